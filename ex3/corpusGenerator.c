@@ -0,0 +1,148 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+
+#define USAGE_ERROR "Usage: Input should be <number of words><vocabulary \
+size> optional - <Zipf exponent><seed>\n"
+#define ALOCATION_FAILURE "Allocation failure: Too much junk on the computer, \
+free some space!"
+#define MIN_ARGS 3
+#define MAX_ARGS 5
+#define BASE 10
+#define DEFAULT_EXPONENT 1.0
+#define DEFAULT_SEED 1
+#define DOT_EVERY 10
+#define MIN_LINE_WORDS 4
+#define LINE_WORDS_RANGE 16
+#define GOLDEN_GAMMA 0x9e3779b97f4a7c15ULL
+#define DOUBLE_BITS 53
+
+/**
+ * draws the next number of a splitmix64 sequence
+ * @param state the state of the sequence, advanced in place
+ * @return the number
+ */
+uint64_t splitmix_next (uint64_t *state)
+{
+  uint64_t z = (*state += GOLDEN_GAMMA);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+/**
+ * @param state the state of the sequence, advanced in place
+ * @return a uniform number in [0, 1)
+ */
+double next_unit (uint64_t *state)
+{
+  return (double) (splitmix_next (state) >> (64 - DOUBLE_BITS))
+         / (double) (1ULL << DOUBLE_BITS);
+}
+
+/**
+ * Builds the running sums of the Zipf weights 1 / rank^exponent of the
+ * ranks 1 to size, normalized so the last one is 1.
+ * @param size the vocabulary size
+ * @param exponent the Zipf exponent
+ * @return the running sums, on the heap
+ */
+double *zipf_cumulative (int size, double exponent)
+{
+  double *cumulative = (double *) malloc (size * sizeof (double));
+  if (cumulative == NULL)
+    {
+      printf (ALOCATION_FAILURE);
+      exit (EXIT_FAILURE);
+    }
+  double sum = 0;
+  for (int rank = 1; rank <= size; ++rank)
+    {
+      sum += 1.0 / pow (rank, exponent);
+      cumulative[rank - 1] = sum;
+    }
+  for (int i = 0; i < size; ++i)
+    {
+      cumulative[i] /= sum;
+    }
+  return cumulative;
+}
+
+/**
+ * Draws a word from the Zipf distribution with a binary search over the
+ * running sums.
+ * @param cumulative the running sums of the distribution
+ * @param size the vocabulary size
+ * @param state the state of the random sequence
+ * @return the index of the word, 0 for the most frequent
+ */
+int draw_word (const double *cumulative, int size, uint64_t *state)
+{
+  double number = next_unit (state);
+  int low = 0;
+  int high = size - 1;
+  while (low < high)
+    {
+      int mid = low + (high - low) / 2;
+      if (cumulative[mid] > number)
+        {
+          high = mid;
+        }
+      else
+        {
+          low = mid + 1;
+        }
+    }
+  return low;
+}
+
+/**
+ * Writes a synthetic corpus to stdout in the format tweetsGenerator reads:
+ * lines of words split by spaces. The words are drawn from a Zipf
+ * distribution over a vocabulary of words w0, w1, ... in order of frequency,
+ * every DOT_EVERY-th of which ends with a dot and so ends a sentence.
+ * Lines have MIN_LINE_WORDS to MIN_LINE_WORDS + LINE_WORDS_RANGE - 1 words.
+ * The same arguments always give the same corpus.
+ * @param argc
+ * @param argv 1) Number of words to write
+ *             2) Vocabulary size
+ *             3) Optional - Zipf exponent, 1.0 by default
+ *             4) Optional - Seed, 1 by default
+ */
+int main (int argc, char *argv[])
+{
+  if (argc < MIN_ARGS || argc > MAX_ARGS)
+    {
+      printf (USAGE_ERROR);
+      return EXIT_FAILURE;
+    }
+  char *ptr = NULL;
+  long long words = strtoll (argv[1], &ptr, BASE);
+  int size = strtol (argv[2], &ptr, BASE);
+  double exponent = argc > MIN_ARGS ? strtod (argv[3], &ptr)
+                                    : DEFAULT_EXPONENT;
+  uint64_t state = argc > MIN_ARGS + 1 ? strtoull (argv[4], &ptr, BASE)
+                                       : DEFAULT_SEED;
+  if (words < 0 || size < 1 || exponent <= 0)
+    {
+      printf (USAGE_ERROR);
+      return EXIT_FAILURE;
+    }
+  double *cumulative = zipf_cumulative (size, exponent);
+  int line_left = 0;
+  for (long long i = 0; i < words; ++i)
+    {
+      if (line_left == 0)
+        {
+          line_left = MIN_LINE_WORDS
+                      + (int) (splitmix_next (&state) % LINE_WORDS_RANGE);
+        }
+      int word = draw_word (cumulative, size, &state);
+      line_left--;
+      printf (word % DOT_EVERY == DOT_EVERY - 1 ? "w%d." : "w%d", word);
+      putchar (line_left == 0 || i == words - 1 ? '\n' : ' ');
+    }
+  free (cumulative);
+  return 0;
+}
@@ -0,0 +1,215 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "tweetsProtocol.h"
+
+#define USAGE_ERROR "Usage: Input should be <socket path><number of clients>\
+<requests per client><tweets per request>\n"
+#define ALOCATION_FAILURE "Allocation failure: Too much junk on the computer, \
+free some space!"
+#define REQUEST_ERROR "Error: A request to the server failed!\n"
+#define CORRECT_NUM_5 5
+#define BASE 10
+#define MAX_CLIENTS 256
+#define LOAD_REPORT "%d requests of %d tweets in %.3f seconds (%.0f \
+requests/sec)\nLatency: p50 %.1f us, p99 %.1f us, max %.1f us\n"
+
+/************ CLIENTS ************/
+/**
+ * @struct Client - one connection sending its requests one after the other.
+ * @param latencies the seconds every request took, filled by the client.
+ * @param failed 1 if a request failed, 0 otherwise.
+ */
+typedef struct Client {
+    const char *path;
+    int number;
+    int requests;
+    int num_of_tweets;
+    double *latencies;
+    int failed;
+} Client;
+
+/**
+ * Connects to the server's socket.
+ * @param path path of the socket
+ * @return the connected socket, -1 on failure
+ */
+int connect_to (const char *path)
+{
+  struct sockaddr_un address;
+  memset (&address, 0, sizeof (address));
+  address.sun_family = AF_UNIX;
+  if (strlen (path) >= sizeof (address.sun_path))
+    {
+      return -1;
+    }
+  strcpy (address.sun_path, path);
+  int fd = socket (AF_UNIX, SOCK_STREAM, 0);
+  if (fd >= 0 && connect (fd, (struct sockaddr *) &address,
+                          sizeof (address)) != 0)
+    {
+      close (fd);
+      return -1;
+    }
+  return fd;
+}
+
+/**
+ * Thread entry point: sends the client's requests over one connection,
+ * every one with its own seed, timing each until its tweets are all read.
+ * @param arg the Client
+ * @return NULL
+ */
+void *run_client (void *arg)
+{
+  Client *client = (Client *) arg;
+  int fd = connect_to (client->path);
+  if (fd < 0)
+    {
+      client->failed = 1;
+      return NULL;
+    }
+  char *tweets = NULL;
+  size_t capacity = 0;
+  for (int i = 0; i < client->requests && client->failed == 0; ++i)
+    {
+      Request request = {(uint32_t) client->num_of_tweets,
+                         client->number * client->requests + i};
+      Response response;
+      double start = get_time ();
+      if (send_all (fd, &request, sizeof (Request)) != 0
+          || receive_all (fd, &response, sizeof (Response)) != 0
+          || response.status != STATUS_OK)
+        {
+          client->failed = 1;
+          break;
+        }
+      if (response.size > capacity)
+        {
+          capacity = response.size;
+          free (tweets);
+          tweets = (char *) malloc (capacity);
+          if (tweets == NULL)
+            {
+              printf (ALOCATION_FAILURE);
+              exit (EXIT_FAILURE);
+            }
+        }
+      if (receive_all (fd, tweets, response.size) != 0)
+        {
+          client->failed = 1;
+          break;
+        }
+      client->latencies[i] = get_time () - start;
+    }
+  free (tweets);
+  close (fd);
+  return NULL;
+}
+
+/**
+ * compares latencies for sorting them from the smallest up
+ * @param a, b pointers to the latencies
+ * @return negative if a comes first, positive if b does, 0 if equal
+ */
+int compare_latencies (const void *a, const void *b)
+{
+  double first = *(const double *) a;
+  double second = *(const double *) b;
+  return (first > second) - (first < second);
+}
+
+/**
+ * @param sorted latencies sorted from the smallest up
+ * @param count number of latencies, at least 1
+ * @param percentile the percentile, in [0, 100]
+ * @return the latency below which the given percentage of them are
+ */
+double percentile_of (const double *sorted, int count, double percentile)
+{
+  int index = (int) (percentile / 100.0 * count + 0.5) - 1;
+  if (index < 0)
+    {
+      index = 0;
+    }
+  return sorted[index < count ? index : count - 1];
+}
+
+/**
+ * Measures a running tweetsGenerator server: every client sends its
+ * requests over its own connection, all clients at once, and the
+ * throughput and latency percentiles of all the requests are printed.
+ * @param argc
+ * @param argv 1) Path to the server's socket
+ *             2) Number of clients
+ *             3) Number of requests per client
+ *             4) Number of tweets per request
+ */
+int main (int argc, char *argv[])
+{
+  if (argc != CORRECT_NUM_5)
+    {
+      printf (USAGE_ERROR);
+      return EXIT_FAILURE;
+    }
+  char *ptr = NULL;
+  int clients = strtol (argv[2], &ptr, BASE);
+  int requests = strtol (argv[3], &ptr, BASE);
+  int num_of_tweets = strtol (argv[4], &ptr, BASE);
+  if (clients < 1 || clients > MAX_CLIENTS || requests < 1
+      || num_of_tweets < 0)
+    {
+      printf (USAGE_ERROR);
+      return EXIT_FAILURE;
+    }
+  int total = clients * requests;
+  double *latencies = (double *) malloc (total * sizeof (double));
+  if (latencies == NULL)
+    {
+      printf (ALOCATION_FAILURE);
+      exit (EXIT_FAILURE);
+    }
+  Client tasks[MAX_CLIENTS];
+  pthread_t workers[MAX_CLIENTS];
+  double start = get_time ();
+  for (int i = 0; i < clients; ++i)
+    {
+      tasks[i] = (Client) {argv[1], i, requests, num_of_tweets,
+                           latencies + i * requests, 0};
+      if (pthread_create (&workers[i], NULL, run_client, &tasks[i]) != 0)
+        {
+          run_client (&tasks[i]);
+          workers[i] = pthread_self ();
+        }
+    }
+  int failed = 0;
+  for (int i = 0; i < clients; ++i)
+    {
+      if (pthread_equal (workers[i], pthread_self ()) == 0)
+        {
+          pthread_join (workers[i], NULL);
+        }
+      failed |= tasks[i].failed;
+    }
+  double elapsed = get_time () - start;
+  if (failed == 1)
+    {
+      printf (REQUEST_ERROR);
+      free (latencies);
+      return EXIT_FAILURE;
+    }
+  qsort (latencies, total, sizeof (double), compare_latencies);
+  printf (LOAD_REPORT, total, num_of_tweets, elapsed,
+          elapsed > 0 ? total / elapsed : 0,
+          percentile_of (latencies, total, 50) * 1e6,
+          percentile_of (latencies, total, 99) * 1e6,
+          latencies[total - 1] * 1e6);
+  free (latencies);
+  return 0;
+}
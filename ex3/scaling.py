@@ -0,0 +1,125 @@
+#! /usr/bin/env python3
+
+import argparse
+import csv
+import json
+import math
+import os
+import subprocess
+import sys
+import tempfile
+
+SIZES = [10 ** 4, 10 ** 5, 10 ** 6, 10 ** 7, 10 ** 8]
+VOCABULARY_RATIO = 10
+MAX_VOCABULARY = 10 ** 6
+TWEETS = 100000
+SEED = 1
+MAX_SLOPE = 1.5
+COLUMNS = ["tokens", "vocabulary", "ingest_sec", "tokens_per_sec",
+           "freeze_sec", "words", "bigrams", "fan_out_max", "generate_sec",
+           "tweets_per_sec"]
+
+
+def vocabulary_of(tokens):
+    """The vocabulary grows with the corpus, like a real one does."""
+    return max(1, min(tokens // VOCABULARY_RATIO, MAX_VOCABULARY))
+
+
+def run_size(args, tokens, directory):
+    """Generates a corpus of the given size and returns the row of stats of
+    building a model from it and generating tweets."""
+    vocabulary = vocabulary_of(tokens)
+    corpus = os.path.join(directory, "corpus_%d.txt" % tokens)
+    with open(corpus, "w") as out:
+        subprocess.run([args.generator, str(tokens), str(vocabulary),
+                        str(args.exponent), str(SEED)], stdout=out,
+                       check=True)
+    result = subprocess.run([args.program, str(SEED), str(args.tweets),
+                             corpus, "--order", str(args.order),
+                             "--threads", str(args.threads),
+                             "--output", os.devnull, "--stats", "json"],
+                            stderr=subprocess.PIPE, check=True, text=True)
+    os.remove(corpus)
+    stats = json.loads(result.stderr.strip().splitlines()[-1])
+    return {"tokens": tokens, "vocabulary": vocabulary,
+            "ingest_sec": stats["phases"]["ingest"],
+            "tokens_per_sec": stats["tokens_per_sec"],
+            "freeze_sec": stats["phases"]["freeze"],
+            "words": stats["words"], "bigrams": stats["bigrams"],
+            "fan_out_max": stats["fan_out_max"],
+            "generate_sec": stats["phases"]["generate"],
+            "tweets_per_sec": stats["tweets_per_sec"]}
+
+
+def slope(rows, column):
+    """The log-log slope of the column against the number of tokens, over
+    the sizes big enough to time reliably: 1 is linear, 2 quadratic."""
+    points = [(math.log(row["tokens"]), math.log(row[column]))
+              for row in rows if row[column] > 0 and row["tokens"] >= 10 ** 5]
+    if len(points) < 2:
+        return None
+    mean_x = sum(x for x, _ in points) / len(points)
+    mean_y = sum(y for _, y in points) / len(points)
+    spread = sum((x - mean_x) ** 2 for x, _ in points)
+    return sum((x - mean_x) * (y - mean_y) for x, y in points) / spread
+
+
+def plot(rows, path):
+    """Plots the ingest and freeze times against the number of tokens."""
+    import matplotlib.pyplot as plt
+    tokens = [row["tokens"] for row in rows]
+    plt.loglog(tokens, [row["ingest_sec"] for row in rows], "o-",
+               label="ingest")
+    plt.loglog(tokens, [row["freeze_sec"] for row in rows], "o-",
+               label="freeze")
+    plt.xlabel("tokens")
+    plt.ylabel("seconds")
+    plt.legend()
+    plt.savefig(path)
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(
+        description="Measures how building a model and generating tweets "
+                    "scale with the size of a synthetic Zipf corpus.")
+    parser.add_argument("--program", required=True,
+                        help="path to the tweetsGenerator executable")
+    parser.add_argument("--generator", required=True,
+                        help="path to the corpusGenerator executable")
+    parser.add_argument("--max-tokens", type=int, default=SIZES[-1])
+    parser.add_argument("--exponent", type=float, default=1.0)
+    parser.add_argument("--order", type=int, default=2)
+    parser.add_argument("--threads", type=int, default=1)
+    parser.add_argument("--tweets", type=int, default=TWEETS)
+    parser.add_argument("--csv", default="scaling.csv")
+    parser.add_argument("--plot", help="path of a plot to save, if given")
+    args = parser.parse_args(argv[1:])
+
+    rows = []
+    with tempfile.TemporaryDirectory() as directory:
+        for tokens in SIZES:
+            if tokens > args.max_tokens:
+                break
+            rows.append(run_size(args, tokens, directory))
+            print(", ".join("%s %s" % (column, rows[-1][column])
+                            for column in COLUMNS))
+            sys.stdout.flush()
+    with open(args.csv, "w", newline="") as out:
+        writer = csv.DictWriter(out, fieldnames=COLUMNS)
+        writer.writeheader()
+        writer.writerows(rows)
+    if args.plot:
+        plot(rows, args.plot)
+
+    ingest = slope(rows, "ingest_sec")
+    if ingest is None:
+        return 0
+    print("Ingest time grows as tokens^%.2f" % ingest)
+    if ingest > MAX_SLOPE:
+        print("Error: ingestion scales worse than linearly!")
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
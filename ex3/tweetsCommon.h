@@ -0,0 +1,16 @@
+#ifndef TWEETS_COMMON_H_
+#define TWEETS_COMMON_H_
+
+/*
+ * What every part of tweetsGenerator shares: the message it fails with when
+ * out of memory, and the constants the parts agree on.
+ */
+
+#define ALOCATION_FAILURE "Allocation failure: Too much junk on the computer, \
+free some space!"
+#define SAME 0
+#define BASE 10
+#define MAX_THREADS 256
+#define MEGABYTE (1024.0 * 1024.0)
+
+#endif //TWEETS_COMMON_H_
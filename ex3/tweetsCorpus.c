@@ -0,0 +1,389 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "tweetsCorpus.h"
+#include "tweetsCommon.h"
+
+#define SIMD_WIDTH 16
+
+/**
+ * @struct Corpus - the whole text of a corpus file.
+ * @param data the characters of the file, not '\0' terminated.
+ * @param size number of characters.
+ * @param mapped 1 if data is a mapping of the file, 0 if it was read into
+ * a heap buffer (for files that can't be mapped, like pipes).
+ */
+typedef struct Corpus {
+    const char *data;
+    size_t size;
+    int mapped;
+} Corpus;
+
+/**
+ * Maps the given file to memory, falling back to reading it whole when it
+ * can't be mapped.
+ * @param fp the opened file
+ * @param corpus the corpus to fill
+ * @return 0 on success, 1 otherwise
+ */
+int open_corpus (FILE *fp, Corpus *corpus)
+{
+  struct stat file_stat;
+  *corpus = (Corpus) {NULL, 0, 0};
+  if (fstat (fileno (fp), &file_stat) == 0 && S_ISREG (file_stat.st_mode))
+    {
+      if (file_stat.st_size == 0)
+        {
+          return 0;
+        }
+      void *data = mmap (NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE,
+                         fileno (fp), 0);
+      if (data != MAP_FAILED)
+        {
+          posix_madvise (data, file_stat.st_size, POSIX_MADV_SEQUENTIAL);
+          *corpus = (Corpus) {data, file_stat.st_size, 1};
+          return 0;
+        }
+    }
+  size_t capacity = BUFSIZ;
+  char *buffer = malloc (capacity);
+  size_t read = 0;
+  while (buffer != NULL)
+    {
+      read += fread (buffer + read, 1, capacity - read, fp);
+      if (read < capacity)
+        {
+          break;
+        }
+      capacity *= 2;
+      char *temp = realloc (buffer, capacity);
+      if (temp == NULL)
+        {
+          free (buffer);
+        }
+      buffer = temp;
+    }
+  if (buffer == NULL)
+    {
+      return 1;
+    }
+  *corpus = (Corpus) {buffer, read, 0};
+  return 0;
+}
+
+/**
+ * Releases the memory of the corpus.
+ * @param corpus the corpus
+ */
+void close_corpus (Corpus *corpus)
+{
+  if (corpus->mapped == 1)
+    {
+      munmap ((void *) corpus->data, corpus->size);
+    }
+  else
+    {
+      free ((void *) corpus->data);
+    }
+  *corpus = (Corpus) {NULL, 0, 0};
+}
+
+/**
+ * @param c a character
+ * @return 1 if the character separates words, 0 otherwise
+ */
+int is_delimiter (char c)
+{
+  return c == ' ' || c == '\n';
+}
+
+/**
+ * Finds the first space or newline at or after pos, scanning SIMD_WIDTH
+ * characters at a time when SSE2 is available.
+ * @param data the characters
+ * @param pos index to start from
+ * @param size number of characters
+ * @return index of the delimiter, size if there is none
+ */
+size_t find_delimiter (const char *data, size_t pos, size_t size)
+{
+#ifdef __SSE2__
+  const __m128i space = _mm_set1_epi8 (' ');
+  const __m128i newline = _mm_set1_epi8 ('\n');
+  while (pos + SIMD_WIDTH <= size)
+    {
+      __m128i chunk = _mm_loadu_si128 ((const __m128i *) (data + pos));
+      int mask = _mm_movemask_epi8 (_mm_or_si128
+                                        (_mm_cmpeq_epi8 (chunk, space),
+                                         _mm_cmpeq_epi8 (chunk, newline)));
+      if (mask != 0)
+        {
+          return pos + __builtin_ctz (mask);
+        }
+      pos += SIMD_WIDTH;
+    }
+#endif
+  while (pos < size && is_delimiter (data[pos]) == 0)
+    {
+      pos++;
+    }
+  return pos;
+}
+
+/**
+ * Read the words of the given characters, which are split to words by
+ * spaces and to sentences by newlines. Add every unique word to the
+ * dictionary. Also, at every iteration, update the prob_list of the previous
+ * word with the value of the current word.
+ * Words are taken as (pointer, length) spans of data, so nothing is copied
+ * but the first occurrence of every word.
+ * @param data the characters
+ * @param size number of characters
+ * @param read_all 1 to read all the words, 0 to read words_to_read of them
+ * @param words_to_read Number of words to read, unless read_all is 1.
+ * @param dictionary Dictionary to fill
+ */
+void fill_dictionary_from (const char *data, size_t size, int read_all,
+                           size_t words_to_read, Dictionary *dictionary)
+{
+  // a corpus may have more words than an int counts
+  size_t word_read = 0;
+  // words are kept by id, since loading a new word may move the array.
+  // history holds the last words of the sentence, up to order - 1 of them,
+  // and is emptied by a newline or a word that ends with a dot
+  int history[MAX_ORDER];
+  int history_size = 0;
+  size_t pos = 0;
+  while (pos < size && (read_all == 1 || word_read < words_to_read))
+    {
+      if (is_delimiter (data[pos]) == 1)
+        {
+          if (data[pos] == '\n')
+            {
+              history_size = 0;
+            }
+          pos++;
+          continue;
+        }
+      size_t end = find_delimiter (data, pos, size);
+      WordStruct *temp_word = load_word (dictionary, data + pos,
+                                         (int) (end - pos));
+      word_read++;
+      if (history_size > 0
+          && dot_at_end (&dictionary->words[history[history_size - 1]]) == 1)
+        {
+          if (dictionary->count_only == 1)
+            {
+              uint32_t index = find_or_add_ngram
+                  (&dictionary->ngrams, pack_key (history[history_size - 1],
+                                                  temp_word->id));
+              dictionary->ngrams.counts[index]++;
+            }
+          else
+            {
+              add_ngrams (dictionary, history, history_size, temp_word, 1);
+            }
+        }
+      else
+        {
+          history_size = 0;
+        }
+      if (history_size == dictionary->order - 1)
+        {
+          memmove (history, history + 1, (history_size - 1) * sizeof (int));
+          history_size--;
+        }
+      history[history_size++] = temp_word->id;
+      pos = end;
+    }
+}
+
+/************ PARALLEL INGESTION ************/
+/**
+ * @struct IngestTask - a part of the corpus read by one thread.
+ * @param data, size the characters of the part, which ends at a newline.
+ * @param dictionary the thread's own dictionary.
+ */
+typedef struct IngestTask {
+    const char *data;
+    size_t size;
+    Dictionary *dictionary;
+} IngestTask;
+
+/**
+ * Thread entry point: fills the task's dictionary from its part.
+ * @param arg the IngestTask
+ * @return NULL
+ */
+void *ingest_part (void *arg)
+{
+  IngestTask *task = (IngestTask *) arg;
+  fill_dictionary_from (task->data, task->size, 1, 0, task->dictionary);
+  return NULL;
+}
+
+/**
+ * Adds the words and successors of part into dictionary.
+ * Words of part are interned in the order of their ids, and successors are
+ * added in the order of their prob_lists, so merging the parts of a corpus
+ * in order gives the same ids and prob_lists as reading it in one pass.
+ * @param dictionary the dictionary to merge into
+ * @param part the dictionary of a later part of the corpus
+ */
+void merge_dictionary (Dictionary *dictionary, Dictionary *part)
+{
+  int *to_global = (int *) malloc ((part->size + 1) * sizeof (int));
+  if (to_global == NULL)
+    {
+      printf(ALOCATION_FAILURE);
+      exit (EXIT_FAILURE);
+    }
+  for (int id = 0; id < part->size; ++id)
+    {
+      WordStruct *word = &part->words[id];
+      WordStruct *temp_word = intern_word (dictionary, word->word,
+                                           word->length);
+      temp_word->number_of_occurrence += word->number_of_occurrence;
+      to_global[id] = temp_word->id;
+    }
+  for (int id = 0; id < part->size; ++id)
+    {
+      WordStruct *word = &part->words[id];
+      for (int i = 0; i < word->prob_list_size; ++i)
+        {
+          add_successor (&dictionary->words[to_global[id]],
+                         to_global[word->prob_list[i].word_id],
+                         word->prob_list[i].num_of_occurrnces);
+        }
+    }
+  // a context is always added after the context it extends, and the ngrams
+  // are added in the order they were first seen
+  uint32_t *context_to_global = (uint32_t *) malloc
+      ((part->contexts.size + 1) * sizeof (uint32_t));
+  if (context_to_global == NULL)
+    {
+      printf(ALOCATION_FAILURE);
+      exit (EXIT_FAILURE);
+    }
+  for (uint32_t i = 0; i < part->contexts.size; ++i)
+    {
+      uint32_t node = part->contexts.keys[i] >> 32;
+      uint32_t word_id = (uint32_t) part->contexts.keys[i];
+      node = (node & CONTEXT_BIT) ? context_to_global[node & ~CONTEXT_BIT]
+                                  : (uint32_t) to_global[node];
+      context_to_global[i] = intern_context (dictionary, node,
+                                             to_global[word_id]);
+    }
+  for (uint32_t i = 0; i < part->ngrams.size; ++i)
+    {
+      // the ngrams of a count_only dictionary are bigrams, keyed by a word
+      uint32_t node = part->ngrams.keys[i] >> 32;
+      node = (node & CONTEXT_BIT) ? context_to_global[node & ~CONTEXT_BIT]
+                                  : (uint32_t) to_global[node];
+      uint32_t word_id = to_global[(uint32_t) part->ngrams.keys[i]];
+      uint32_t index = find_or_add_ngram (&dictionary->ngrams,
+                                          pack_key (node, word_id));
+      dictionary->ngrams.counts[index] += part->ngrams.counts[i];
+    }
+  free (context_to_global);
+  free (to_global);
+}
+
+/**
+ * Fills the dictionary from the whole of the given characters using the
+ * given number of threads. The characters are split at newlines, every
+ * thread reads its part into its own dictionary, and the parts are merged
+ * in order, which gives exactly the dictionary of a single pass.
+ * @param data the characters
+ * @param size number of characters
+ * @param threads number of threads to use
+ * @param dictionary Empty dictionary to fill
+ */
+void fill_dictionary_parallel (const char *data, size_t size, int threads,
+                               Dictionary *dictionary)
+{
+  // the data of an empty corpus may be NULL
+  if (size == 0)
+    {
+      return;
+    }
+  pthread_t workers[MAX_THREADS];
+  IngestTask tasks[MAX_THREADS];
+  size_t start = 0;
+  for (int i = 0; i < threads; ++i)
+    {
+      size_t end = i == threads - 1 ? size : size / threads * (i + 1);
+      if (end < start)
+        {
+          end = start;
+        }
+      if (end < size)
+        {
+          const char *newline = memchr (data + end, '\n', size - end);
+          end = newline == NULL ? size : (size_t) (newline - data) + 1;
+        }
+      tasks[i].data = data + start;
+      tasks[i].size = end - start;
+      tasks[i].dictionary = new_dictionary (dictionary->order);
+      tasks[i].dictionary->count_only = dictionary->count_only;
+      if (pthread_create (&workers[i], NULL, ingest_part, &tasks[i]) != 0)
+        {
+          ingest_part (&tasks[i]);
+          workers[i] = pthread_self ();
+        }
+      start = end;
+    }
+  for (int i = 0; i < threads; ++i)
+    {
+      if (pthread_equal (workers[i], pthread_self ()) == 0)
+        {
+          pthread_join (workers[i], NULL);
+        }
+      merge_dictionary (dictionary, tasks[i].dictionary);
+      free_dictionary (tasks[i].dictionary);
+    }
+}
+
+/**
+ * Read word from the given file. Add every unique word to the dictionary.
+ * Also, at every iteration, update the prob_list of the previous word with
+ * the value of the current word.
+ * @param fp File pointer
+ * @param words_to_read Number of words to read from file.
+ *                      If value is bigger than the file's word count,
+ *                      or if words_to_read is negative (-1) than read
+ *                      entire file.
+ * @param dictionary Empty dictionary to fill
+ * @param threads number of threads to read with, used only when reading the
+ * entire file
+ */
+void fill_dictionary (FILE *fp, int words_to_read, Dictionary *dictionary,
+                      int threads)
+{
+  Corpus corpus;
+  if (open_corpus (fp, &corpus) != 0)
+    {
+      printf(ALOCATION_FAILURE);
+      exit (EXIT_FAILURE);
+    }
+  int read_all = words_to_read < 0;
+  if (threads > 1 && read_all == 1)
+    {
+      fill_dictionary_parallel (corpus.data, corpus.size, threads, dictionary);
+    }
+  else
+    {
+      fill_dictionary_from (corpus.data, corpus.size, read_all,
+                            read_all == 1 ? 0 : (size_t) words_to_read,
+                            dictionary);
+    }
+  close_corpus (&corpus);
+}
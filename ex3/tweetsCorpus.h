@@ -0,0 +1,28 @@
+#ifndef TWEETS_CORPUS_H_
+#define TWEETS_CORPUS_H_
+
+#include <stdio.h>
+#include "tweetsDictionary.h"
+
+/*
+ * Reading a corpus file into a dictionary, splitting it into words,
+ * in parallel when it is read whole.
+ */
+
+/**
+ * Read word from the given file. Add every unique word to the dictionary.
+ * Also, at every iteration, update the prob_list of the previous word with
+ * the value of the current word.
+ * @param fp File pointer
+ * @param words_to_read Number of words to read from file.
+ *                      If value is bigger than the file's word count,
+ *                      or if words_to_read is negative (-1) than read
+ *                      entire file.
+ * @param dictionary Empty dictionary to fill
+ * @param threads number of threads to read with, used only when reading the
+ * entire file
+ */
+void fill_dictionary (FILE *fp, int words_to_read, Dictionary *dictionary,
+                      int threads);
+
+#endif //TWEETS_CORPUS_H_
@@ -0,0 +1,561 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "tweetsDictionary.h"
+#include "tweetsCommon.h"
+
+#define STARTERS_INITIAL_CAP 16
+#define PROB_LIST_INITIAL_CAP 4
+#define SLOTS_INITIAL_CAP 8
+#define ARENA_BLOCK_SIZE 65536
+#define HASH_MULTIPLIER 2654435761u
+#define FNV_OFFSET 2166136261u
+#define FNV_PRIME 16777619u
+
+/**
+ * Copies the given characters into the arena, adding a terminating '\0'.
+ * A new block is chained in front of the arena when the current one is full.
+ * @param dictionary the dictionary owning the arena
+ * @param word the characters to copy
+ * @param length number of characters to copy
+ * @return the interned copy
+ */
+char *arena_copy (Dictionary *dictionary, const char *word, int length)
+{
+  size_t needed = (size_t) length + 1;
+  ArenaBlock *block = dictionary->arena;
+  if (block == NULL || block->capacity - block->used < needed)
+    {
+      size_t capacity = needed > ARENA_BLOCK_SIZE ? needed : ARENA_BLOCK_SIZE;
+      block = (ArenaBlock *) malloc (sizeof (ArenaBlock) + capacity);
+      if (block == NULL)
+        {
+          printf(ALOCATION_FAILURE);
+          exit (EXIT_FAILURE);
+        }
+      block->next = dictionary->arena;
+      block->used = 0;
+      block->capacity = capacity;
+      dictionary->arena = block;
+    }
+  char *copy = block->data + block->used;
+  memcpy (copy, word, length);
+  copy[length] = '\0';
+  block->used += needed;
+  return copy;
+}
+
+WordStruct *memory_allocation (WordStruct *word, int word_or_prob_list);
+
+/**
+ * hashes a word id into the successor slots table of a word
+ * @param id the word id
+ * @param capacity the table capacity, a power of 2
+ * @return the first slot to probe
+ */
+int slot_of (int id, int capacity)
+{
+  return (int) (((unsigned int) id * HASH_MULTIPLIER) & (capacity - 1));
+}
+
+/**
+ * This function checks if the next word already in the probability list of
+ * the current word, by looking up the id of next word in the successor slots
+ * of the current word
+ * @param curr_word the current word
+ * @param next_id the id of the next word
+ * @return pointer to word if the word exists else NULL
+ */
+WordProbability *check_if_exists (WordStruct *curr_word, int next_id)
+{
+  if (curr_word->successor_slots == NULL)
+    {
+      return NULL;
+    }
+  int mask = curr_word->successor_slots_capacity - 1;
+  int slot = slot_of (next_id, curr_word->successor_slots_capacity);
+  while (curr_word->successor_slots[slot] != 0)
+    {
+      WordProbability *temp =
+          &curr_word->prob_list[curr_word->successor_slots[slot] - 1];
+      if (temp->word_id == next_id)
+        {
+          return temp;
+        }
+      slot = (slot + 1) & mask;
+    }
+  return NULL;
+}
+
+/**
+ * places the prob_list entry at the given index in the successor slots of
+ * the word
+ * @param word the word owning the slots
+ * @param index index of the entry in word->prob_list
+ */
+void insert_slot (WordStruct *word, int index)
+{
+  int mask = word->successor_slots_capacity - 1;
+  int slot = slot_of (word->prob_list[index].word_id,
+                      word->successor_slots_capacity);
+  while (word->successor_slots[slot] != 0)
+    {
+      slot = (slot + 1) & mask;
+    }
+  word->successor_slots[slot] = index + 1;
+}
+
+/**
+ * Adds count occurrences of the word with the given id to the prob_list of
+ * first_word, appending it to the list if it isn't there yet.
+ * @param first_word
+ * @param second_id the id of the following word
+ * @param count number of occurrences to add
+ * @return 0 if already in list, 1 otherwise.
+ */
+int add_successor (WordStruct *first_word, int second_id, int count)
+{
+  WordProbability *pos = check_if_exists (first_word, second_id);
+  first_word->prob_list_size_with_duplicats += count;
+  if (pos != NULL)
+    {
+      pos->num_of_occurrnces += count;
+      return 0;
+    }
+  if (first_word->prob_list == NULL)
+    {
+      memory_allocation (first_word, 1);
+    }
+  else if (first_word->prob_list_size == first_word->prob_list_capacity)
+    {
+      memory_allocation (first_word, 2);
+    }
+  int index = first_word->prob_list_size;
+  first_word->prob_list[index].word_id = second_id;
+  first_word->prob_list[index].num_of_occurrnces = count;
+  first_word->prob_list_size += 1;
+  insert_slot (first_word, index);
+  return 1;
+}
+
+/**
+ * Gets 2 WordStructs. If second_word in first_word's prob_list,
+ * update the existing probability value.
+ * Otherwise, add the second word to the prob_list of the first word.
+ * @param first_word
+ * @param second_word
+ * @return 0 if already in list, 1 otherwise.
+ */
+int
+add_word_to_probability_list (WordStruct *first_word, WordStruct *second_word)
+{
+  return add_successor (first_word, second_word->id, 1);
+}
+
+/************ N-GRAMS ************/
+/**
+ * places the entry at the given index in the slots of the table
+ * @param table the table
+ * @param index index of the entry
+ */
+void insert_ngram_slot (NgramTable *table, uint32_t index)
+{
+  uint32_t mask = table->slots_capacity - 1;
+  uint32_t slot = (uint32_t) hash_key (table->keys[index]) & mask;
+  while (table->slots[slot] != 0)
+    {
+      slot = (slot + 1) & mask;
+    }
+  table->slots[slot] = index + 1;
+}
+
+/**
+ * Finds the entry of the key in the table, appending an entry with a zero
+ * count if it isn't there. The entries and the slots double when full.
+ * @param table the table
+ * @param key the key
+ * @return index of the entry
+ */
+uint32_t find_or_add_ngram (NgramTable *table, uint64_t key)
+{
+  if (table->slots != NULL)
+    {
+      uint32_t mask = table->slots_capacity - 1;
+      uint32_t slot = (uint32_t) hash_key (key) & mask;
+      while (table->slots[slot] != 0)
+        {
+          if (table->keys[table->slots[slot] - 1] == key)
+            {
+              return table->slots[slot] - 1;
+            }
+          slot = (slot + 1) & mask;
+        }
+    }
+  if (table->size == table->capacity)
+    {
+      table->capacity = table->capacity == 0 ? NGRAM_INITIAL_CAP
+                                             : table->capacity * 2;
+      table->keys = (uint64_t *) realloc (table->keys, table->capacity
+                                                       * sizeof (uint64_t));
+      table->counts = (uint32_t *) realloc (table->counts, table->capacity
+                                                           * sizeof (uint32_t));
+      free (table->slots);
+      table->slots_capacity = table->capacity * 2;
+      table->slots = (uint32_t *) calloc (table->slots_capacity,
+                                          sizeof (uint32_t));
+      if (table->keys == NULL || table->counts == NULL || table->slots == NULL)
+        {
+          printf(ALOCATION_FAILURE);
+          exit (EXIT_FAILURE);
+        }
+      for (uint32_t i = 0; i < table->size; ++i)
+        {
+          insert_ngram_slot (table, i);
+        }
+    }
+  uint32_t index = table->size;
+  table->keys[index] = key;
+  table->counts[index] = 0;
+  table->size++;
+  insert_ngram_slot (table, index);
+  return index;
+}
+
+/**
+ * Frees the memory of the table.
+ * @param table the table
+ */
+void free_ngram_table (NgramTable *table)
+{
+  free (table->keys);
+  free (table->counts);
+  free (table->slots);
+}
+
+/**
+ * Finds the context made of the given node followed by the given word,
+ * adding it to the dictionary if it is new.
+ * @param dictionary the dictionary
+ * @param node node of the context's words but the last
+ * @param word_id id of the context's last word
+ * @return the node of the context
+ */
+uint32_t intern_context (Dictionary *dictionary, uint32_t node,
+                         uint32_t word_id)
+{
+  return CONTEXT_BIT | find_or_add_ngram (&dictionary->contexts,
+                                          pack_key (node, word_id));
+}
+
+/**
+ * Counts the word following each of the contexts of the history of words
+ * before it.
+ * The previous word is counted in its prob_list. Longer contexts are
+ * interned word by word from the start of the context, so every context
+ * that is interned is followed by at least one word.
+ * @param dictionary the dictionary
+ * @param history ids of the words before the word, oldest first
+ * @param history_size number of words in history, at most order - 1
+ * @param word the following word
+ * @param count number of times to count it
+ */
+void add_ngrams (Dictionary *dictionary, const int *history, int history_size,
+                 WordStruct *word, int count)
+{
+  add_successor (&dictionary->words[history[history_size - 1]], word->id,
+                 count);
+  for (int length = 2; length <= history_size; ++length)
+    {
+      const int *context = history + history_size - length;
+      uint32_t node = context[0];
+      for (int i = 1; i < length; ++i)
+        {
+          node = intern_context (dictionary, node, context[i]);
+        }
+      uint32_t index = find_or_add_ngram (&dictionary->ngrams,
+                                          pack_key (node, word->id));
+      dictionary->ngrams.counts[index] += count;
+    }
+}
+
+/**
+ * checks if there is a dot at the end of the world
+ * @param prev_word the word to check
+ * @return 0 if ends with a dot else 1
+ */
+int dot_at_end (WordStruct *prev_word)
+{
+  if (prev_word == NULL)
+    {
+      return 0;
+    }
+  if (prev_word->word[prev_word->length - 1] == '.')
+    {
+      return 0;
+    }
+  return 1;
+}
+
+/**
+ * handles the memory allocation of the probability lists
+ * @param word the WordStruct to allocate memory for
+ * @param word_or_prob_list a flag determining the memory type: 1 for a new
+ * prob_list, 2 for a prob_list that is full
+ * @return a pointer to the WordStruct
+ */
+WordStruct *memory_allocation (WordStruct *word, int word_or_prob_list)
+{
+  if (word_or_prob_list == 1)
+    {
+      word->prob_list = (WordProbability *) calloc (PROB_LIST_INITIAL_CAP,
+                                                    sizeof (WordProbability));
+      word->successor_slots = (int *) calloc (SLOTS_INITIAL_CAP, sizeof (int));
+      if (word->prob_list == NULL || word->successor_slots == NULL)
+        {
+          printf(ALOCATION_FAILURE);
+          exit (EXIT_FAILURE);
+        }
+      word->prob_list_capacity = PROB_LIST_INITIAL_CAP;
+      word->successor_slots_capacity = SLOTS_INITIAL_CAP;
+    }
+  if (word_or_prob_list == 2)
+    {
+      // the prob_list and its slots grow together, keeping the slots table
+      // at most half full
+      word->prob_list_capacity *= 2;
+      word->prob_list = (WordProbability *) realloc (word->prob_list,
+                                                     word->prob_list_capacity
+                                                     * sizeof (WordProbability));
+      free (word->successor_slots);
+      word->successor_slots_capacity *= 2;
+      word->successor_slots = (int *) calloc (word->successor_slots_capacity,
+                                              sizeof (int));
+      if (word->prob_list == NULL || word->successor_slots == NULL)
+        {
+          printf(ALOCATION_FAILURE);
+          exit (EXIT_FAILURE);
+        }
+      for (int i = 0; i < word->prob_list_size; ++i)
+        {
+          insert_slot (word, i);
+        }
+    }
+  return word;
+}
+
+/**
+ * adds a word that can open a sentence to the dictionary's starters array,
+ * doubling the array when it is full
+ * @param dictionary the dictionary
+ * @param word the WordStruct to add
+ */
+void add_starter (Dictionary *dictionary, WordStruct *word)
+{
+  if (dictionary->starters_size == dictionary->starters_capacity)
+    {
+      int new_capacity = dictionary->starters_capacity == 0
+                         ? STARTERS_INITIAL_CAP
+                         : dictionary->starters_capacity * 2;
+      int *temp = (int *) realloc (dictionary->starters,
+                                   new_capacity * sizeof (int));
+      if (temp == NULL)
+        {
+          printf(ALOCATION_FAILURE);
+          exit (EXIT_FAILURE);
+        }
+      dictionary->starters = temp;
+      dictionary->starters_capacity = new_capacity;
+    }
+  dictionary->starters[dictionary->starters_size] = word->id;
+  dictionary->starters_size++;
+}
+
+/**
+ * FNV-1a hash of the given characters
+ * @param word the characters
+ * @param length number of characters
+ * @return the hash
+ */
+unsigned int hash_word (const char *word, int length)
+{
+  unsigned int hash = FNV_OFFSET;
+  for (int i = 0; i < length; ++i)
+    {
+      hash = (hash ^ (unsigned char) word[i]) * FNV_PRIME;
+    }
+  return hash;
+}
+
+/**
+ * places the word with the given id in the dictionary's word slots
+ * @param dictionary the dictionary
+ * @param id the id of the word
+ */
+void insert_word_slot (Dictionary *dictionary, int id)
+{
+  WordStruct *word = &dictionary->words[id];
+  int mask = dictionary->word_slots_capacity - 1;
+  int slot = (int) (hash_word (word->word, word->length) & mask);
+  while (dictionary->word_slots[slot] != 0)
+    {
+      slot = (slot + 1) & mask;
+    }
+  dictionary->word_slots[slot] = id + 1;
+}
+
+/**
+ * makes room in the dictionary for one more word, doubling the words array
+ * and the word slots when needed
+ * @param dictionary the dictionary
+ */
+void grow_dictionary (Dictionary *dictionary)
+{
+  if (dictionary->size == dictionary->capacity)
+    {
+      int new_capacity = dictionary->capacity == 0 ? WORDS_INITIAL_CAP
+                                                   : dictionary->capacity * 2;
+      WordStruct *temp = (WordStruct *) realloc (dictionary->words,
+                                                 new_capacity
+                                                 * sizeof (WordStruct));
+      if (temp == NULL)
+        {
+          printf(ALOCATION_FAILURE);
+          exit (EXIT_FAILURE);
+        }
+      dictionary->words = temp;
+      dictionary->capacity = new_capacity;
+    }
+  if ((dictionary->size + 1) * 2 > dictionary->word_slots_capacity)
+    {
+      free (dictionary->word_slots);
+      dictionary->word_slots_capacity = dictionary->word_slots_capacity == 0
+                                        ? WORDS_INITIAL_CAP * 2
+                                        : dictionary->word_slots_capacity * 2;
+      dictionary->word_slots = (int *) calloc
+          (dictionary->word_slots_capacity, sizeof (int));
+      if (dictionary->word_slots == NULL)
+        {
+          printf(ALOCATION_FAILURE);
+          exit (EXIT_FAILURE);
+        }
+      for (int id = 0; id < dictionary->size; ++id)
+        {
+          insert_word_slot (dictionary, id);
+        }
+    }
+}
+
+/**
+ * finds the word in the dictionary, interning it in the arena and giving it
+ * the next id if it is seen for the first time
+ * @param dictionary the dictionary
+ * @param word the word, not necessarily '\0' terminated
+ * @param length number of characters in the word
+ * @return the WordStruct of the word
+ */
+WordStruct *intern_word (Dictionary *dictionary, const char *word, int length)
+{
+  WordStruct *temp_word = check_word (dictionary, word, length);
+  if (temp_word == NULL)
+    {
+      grow_dictionary (dictionary);
+      temp_word = &dictionary->words[dictionary->size];
+      memset (temp_word, 0, sizeof (WordStruct));
+      temp_word->word = arena_copy (dictionary, word, length);
+      temp_word->length = length;
+      temp_word->id = dictionary->size;
+      dictionary->size++;
+      insert_word_slot (dictionary, temp_word->id);
+      if (dot_at_end (temp_word) == 1)
+        {
+          add_starter (dictionary, temp_word);
+        }
+    }
+  return temp_word;
+}
+
+/**
+ * loads the word to the dictionary, counting one more occurrence of it
+ * @param dictionary the dictionary
+ * @param word the word, not necessarily '\0' terminated
+ * @param length number of characters in the word
+ * @return the WordStruct of the word
+ */
+WordStruct *load_word (Dictionary *dictionary, const char *word, int length)
+{
+  WordStruct *temp_word = intern_word (dictionary, word, length);
+  temp_word->number_of_occurrence += 1;
+  return temp_word;
+}
+
+/**
+ * checks if the word already exists in the dictionary
+ * @param dictionary the dictionary
+ * @param word the word being checks, not necessarily '\0' terminated
+ * @param length number of characters in the word
+ * @return a pointer to the relevant WordStruct else NULL
+ */
+WordStruct *check_word (Dictionary *dictionary, const char *word, int length)
+{
+  if (dictionary->word_slots == NULL)
+    {
+      return NULL;
+    }
+  int mask = dictionary->word_slots_capacity - 1;
+  int slot = (int) (hash_word (word, length) & mask);
+  while (dictionary->word_slots[slot] != 0)
+    {
+      WordStruct *temp = &dictionary->words[dictionary->word_slots[slot] - 1];
+      if (temp->length == length && memcmp (temp->word, word, length) == SAME)
+        {
+          return temp;
+        }
+      slot = (slot + 1) & mask;
+    }
+  return NULL;
+}
+
+/**
+ * Allocates an empty dictionary.
+ * @param order the order of the Markov chain to build
+ * @return the dictionary
+ */
+Dictionary *new_dictionary (int order)
+{
+  Dictionary *dictionary = (Dictionary *) calloc (1, sizeof (Dictionary));
+  if (dictionary == NULL)
+    {
+      printf(ALOCATION_FAILURE);
+      exit (EXIT_FAILURE);
+    }
+  dictionary->order = order;
+  return dictionary;
+}
+
+/**
+ * Free the given dictionary and all of it's content from memory.
+ * The words' characters live in the arena, which is released block by block.
+ * @param dictionary Dictionary to free
+ */
+void free_dictionary (Dictionary *dictionary)
+{
+  for (int id = 0; id < dictionary->size; ++id)
+    {
+      free (dictionary->words[id].prob_list);
+      free (dictionary->words[id].successor_slots);
+    }
+  ArenaBlock *block = dictionary->arena;
+  while (block != NULL)
+    {
+      ArenaBlock *next = block->next;
+      free (block);
+      block = next;
+    }
+  free (dictionary->words);
+  free (dictionary->word_slots);
+  free (dictionary->starters);
+  free_ngram_table (&dictionary->contexts);
+  free_ngram_table (&dictionary->ngrams);
+  free (dictionary);
+}
@@ -0,0 +1,222 @@
+#ifndef TWEETS_DICTIONARY_H_
+#define TWEETS_DICTIONARY_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+
+/*
+ * The dictionary a corpus is read into: every unique word, its successors,
+ * and the longer contexts of the Markov chain.
+ */
+
+#define MIN_ORDER 2
+#define MAX_ORDER 4
+#define CONTEXT_BIT 0x80000000u
+#define EMPTY_KEY UINT64_MAX
+#define NGRAM_INITIAL_CAP 64
+#define WORDS_INITIAL_CAP 64
+
+typedef struct WordStruct {
+    char *word; // interned in the dictionary's arena
+    int length;
+    int id; // position of the word in the dictionary
+    int number_of_occurrence;
+    int prob_list_size;
+    int prob_list_size_with_duplicats;
+    int prob_list_capacity;
+    struct WordProbability *prob_list;
+    int *successor_slots; // open addressing table: successor id -> index + 1
+    int successor_slots_capacity;
+} WordStruct;
+
+typedef struct WordProbability {
+    int word_id;
+    int num_of_occurrnces;
+
+} WordProbability;
+
+typedef struct ArenaBlock {
+    struct ArenaBlock *next;
+    size_t used;
+    size_t capacity;
+    char data[];
+} ArenaBlock;
+
+/**
+ * @struct NgramTable - an insertion ordered hash table of counts keyed by
+ * a packed pair of 32 bit ids.
+ * @param keys, counts the entries, in the order they were added.
+ * @param slots open addressing table: hash of key -> entry index + 1.
+ */
+typedef struct NgramTable {
+    uint64_t *keys;
+    uint32_t *counts;
+    uint32_t size;
+    uint32_t capacity;
+    uint32_t *slots;
+    uint32_t slots_capacity;
+} NgramTable;
+
+/**
+ * @struct Dictionary - every unique word of the corpus.
+ * @param words contiguous array of the words, indexed by their id.
+ * @param word_slots open addressing table: hash of word -> id + 1.
+ * @param arena bump allocated blocks holding the words' characters.
+ * @param starters ids of the words that don't end with a dot.
+ * @param order the order of the Markov chain: a word is conditioned on up
+ * to order - 1 words before it. The previous word alone is covered by the
+ * words' prob_lists, longer contexts by the two tables below.
+ * @param contexts the contexts of 2 words or more, keyed by (node of the
+ * context without its last word, last word id). A node is a word id, or
+ * CONTEXT_BIT | index of a context in this table.
+ * @param ngrams the number of times a word followed a context, keyed by
+ * (node of the context, word id).
+ * @param count_only 1 if only the words and bigrams are counted, in which
+ * case the prob_lists stay empty and ngrams counts the bigrams, keyed by
+ * (id of the first word, id of the second word).
+ */
+typedef struct Dictionary {
+    WordStruct *words;
+    int size;
+    int capacity;
+    int *word_slots;
+    int word_slots_capacity;
+    ArenaBlock *arena;
+    int *starters;
+    int starters_size;
+    int starters_capacity;
+    int order;
+    NgramTable contexts;
+    NgramTable ngrams;
+    int count_only;
+} Dictionary;
+
+/**
+ * Adds count occurrences of the word with the given id to the prob_list of
+ * first_word, appending it to the list if it isn't there yet.
+ * @param first_word
+ * @param second_id the id of the following word
+ * @param count number of occurrences to add
+ * @return 0 if already in list, 1 otherwise.
+ */
+int add_successor (WordStruct *first_word, int second_id, int count);
+
+/**
+ * Finds the entry of the key in the table, appending an entry with a zero
+ * count if it isn't there. The entries and the slots double when full.
+ * @param table the table
+ * @param key the key
+ * @return index of the entry
+ */
+uint32_t find_or_add_ngram (NgramTable *table, uint64_t key);
+
+/**
+ * Finds the context made of the given node followed by the given word,
+ * adding it to the dictionary if it is new.
+ * @param dictionary the dictionary
+ * @param node node of the context's words but the last
+ * @param word_id id of the context's last word
+ * @return the node of the context
+ */
+uint32_t intern_context (Dictionary *dictionary, uint32_t node,
+                         uint32_t word_id);
+
+/**
+ * Counts the word following each of the contexts of the history of words
+ * before it.
+ * The previous word is counted in its prob_list. Longer contexts are
+ * interned word by word from the start of the context, so every context
+ * that is interned is followed by at least one word.
+ * @param dictionary the dictionary
+ * @param history ids of the words before the word, oldest first
+ * @param history_size number of words in history, at most order - 1
+ * @param word the following word
+ * @param count number of times to count it
+ */
+void add_ngrams (Dictionary *dictionary, const int *history, int history_size,
+                 WordStruct *word, int count);
+
+/**
+ * checks if there is a dot at the end of the world
+ * @param prev_word the word to check
+ * @return 0 if ends with a dot else 1
+ */
+int dot_at_end (WordStruct *prev_word);
+
+/**
+ * FNV-1a hash of the given characters
+ * @param word the characters
+ * @param length number of characters
+ * @return the hash
+ */
+unsigned int hash_word (const char *word, int length);
+
+/**
+ * finds the word in the dictionary, interning it in the arena and giving it
+ * the next id if it is seen for the first time
+ * @param dictionary the dictionary
+ * @param word the word, not necessarily '\0' terminated
+ * @param length number of characters in the word
+ * @return the WordStruct of the word
+ */
+WordStruct *intern_word (Dictionary *dictionary, const char *word, int length);
+
+/**
+ * loads the word to the dictionary, counting one more occurrence of it
+ * @param dictionary the dictionary
+ * @param word the word, not necessarily '\0' terminated
+ * @param length number of characters in the word
+ * @return the WordStruct of the word
+ */
+WordStruct *load_word (Dictionary *dictionary, const char *word, int length);
+
+/**
+ * checks if the word already exists in the dictionary
+ * @param dictionary the dictionary
+ * @param word the word being checks, not necessarily '\0' terminated
+ * @param length number of characters in the word
+ * @return a pointer to the relevant WordStruct else NULL
+ */
+WordStruct *check_word (Dictionary *dictionary, const char *word, int length);
+
+/**
+ * Allocates an empty dictionary.
+ * @param order the order of the Markov chain to build
+ * @return the dictionary
+ */
+Dictionary *new_dictionary (int order);
+
+/**
+ * Free the given dictionary and all of it's content from memory.
+ * The words' characters live in the arena, which is released block by block.
+ * @param dictionary Dictionary to free
+ */
+void free_dictionary (Dictionary *dictionary);
+
+/*
+ * The keys below are packed and hashed on every word read and generated,
+ * by the other parts too, so they are defined here, inline.
+ */
+
+/**
+ * @param high, low two 32 bit ids
+ * @return the ids packed into a key of an NgramTable
+ */
+static inline uint64_t pack_key (uint32_t high, uint32_t low)
+{
+  return ((uint64_t) high << 32) | low;
+}
+
+/**
+ * mixes the bits of a packed key (the splitmix64 finalizer)
+ * @param key the key
+ * @return the hash of the key
+ */
+static inline uint64_t hash_key (uint64_t key)
+{
+  key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  key = (key ^ (key >> 27)) * 0x94d049bb133111ebULL;
+  return key ^ (key >> 31);
+}
+
+#endif //TWEETS_DICTIONARY_H_
@@ -0,0 +1,747 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "tweetsGeneration.h"
+#include "tweetsCommon.h"
+
+#define TWEET_PREFIX "Tweet "
+#define TWEET_SUFFIX ": "
+#define UNREACHABLE UINT32_MAX
+#define GENERATION_BATCH 4096
+#define GOLDEN_GAMMA 0x9e3779b97f4a7c15ULL
+#define WYRAND_PRIME 0xe7037ed1a0b428dbULL
+
+/************ RANDOM ************/
+/**
+ * @param x the state of a splitmix64 generator, advanced in place
+ * @return the next output of the generator
+ */
+uint64_t splitmix_next (uint64_t *x)
+{
+  uint64_t z = (*x += GOLDEN_GAMMA);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+/**
+ * Seeds the generator of a tweet.
+ * @param rng the generator
+ * @param seed the seed of the run
+ * @param tweet the number of the tweet
+ */
+void seed_rng (Rng *rng, int seed, uint32_t tweet)
+{
+  uint64_t x = ((uint64_t) (uint32_t) seed << 32) | tweet;
+  for (int i = 0; i < 4; ++i)
+    {
+      rng->state[i] = splitmix_next (&x);
+    }
+}
+
+#ifdef RNG_WYRAND
+/**
+ * @param rng the generator, advanced in place
+ * @return the next 64 random bits of the generator
+ */
+uint64_t rng_next (Rng *rng)
+{
+  rng->state[0] += GOLDEN_GAMMA;
+  __uint128_t product = (__uint128_t) rng->state[0]
+                        * (rng->state[0] ^ WYRAND_PRIME);
+  return (uint64_t) (product >> 64) ^ (uint64_t) product;
+}
+#else
+/**
+ * @param x a 64 bit number
+ * @param k number of bits to rotate by
+ * @return x rotated left by k bits
+ */
+uint64_t rotate_left (uint64_t x, int k)
+{
+  return (x << k) | (x >> (64 - k));
+}
+
+/**
+ * @param rng the generator, advanced in place
+ * @return the next 64 random bits of the generator
+ */
+uint64_t rng_next (Rng *rng)
+{
+  uint64_t *s = rng->state;
+  uint64_t result = rotate_left (s[1] * 5, 7) * 9;
+  uint64_t t = s[1] << 17;
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = rotate_left (s[3], 45);
+  return result;
+}
+#endif
+
+/*************************************/
+/**
+ * Get random number between 0 and max_number [0, max_number), drawn
+ * uniformly with Lemire's nearly divisionless method: the high half of
+ * a random 32 bit number times max_number is the result, and a division
+ * is only needed, to reject the few biased products, when the low half is
+ * smaller than max_number.
+ * @param rng the generator to draw from
+ * @param max_number
+ * @return Random number
+ */
+uint32_t get_random_number (Rng *rng, uint32_t max_number)
+{
+  uint64_t product = (rng_next (rng) >> 32) * max_number;
+  uint32_t low = (uint32_t) product;
+  if (low < max_number)
+    {
+      uint32_t threshold = -max_number % max_number;
+      while (low < threshold)
+        {
+          product = (rng_next (rng) >> 32) * max_number;
+          low = (uint32_t) product;
+        }
+    }
+  return (uint32_t) (product >> 32);
+}
+
+/**
+ * Choose randomly the next word from the given model, drawn uniformly.
+ * The function won't return a word that end's in full stop '.' (Nekuda).
+ * Words are drawn from the model's starters array, which holds exactly
+ * the words that don't end with a dot, so a single draw is enough.
+ * @param model Model to choose a word from
+ * @param rng the generator to draw from
+ * @return id of the chosen word, -1 if there is no such word
+ */
+int64_t get_first_random_word (const Model *model, Rng *rng)
+{
+  if (model->header->starter_count == 0)
+    {
+      return -1;
+    }
+  uint32_t word_number = get_random_number (rng,
+                                            model->header->starter_count);
+  return model->starters[word_number];
+}
+
+/**
+ * Choose randomly the next word. Depend on it's occurrence frequency
+ * as a successor of the given node.
+ * The word is drawn from the alias table of the node's row, which reads one
+ * entry of the table and the total of the row whatever the row's length.
+ * @param model the model
+ * @param node the word or context to choose from
+ * @param rng the generator to draw from
+ * @return id of the chosen word, -1 if the node has no successors
+ */
+int64_t get_next_random_word (const Model *model, uint32_t node, Rng *rng)
+{
+  uint64_t low = model->rows[node];
+  uint64_t high = model->rows[node + 1];
+  if (low == high)
+    {
+      return -1;
+    }
+  const AliasEntry *entry = &model->alias[low + get_random_number
+      (rng, (uint32_t) (high - low))];
+  uint32_t number = get_random_number (rng, model->cumulative[high - 1]);
+  return number < entry->threshold ? entry->successor : entry->alias;
+}
+
+/**
+ * Chooses the next word like get_next_random_word, with a binary search
+ * over the running sums of the node's row instead of its alias table.
+ * A draw costs O(log successors) reads spread over the row. Kept to
+ * compare the two when benchmarking.
+ * @param model the model
+ * @param node the word or context to choose from
+ * @param rng the generator to draw from
+ * @return id of the chosen word, -1 if the node has no successors
+ */
+int64_t get_next_cumulative_word (const Model *model, uint32_t node,
+                                  Rng *rng)
+{
+  uint64_t low = model->rows[node];
+  uint64_t high = model->rows[node + 1];
+  if (low == high)
+    {
+      return -1;
+    }
+  high--;
+  uint32_t number = get_random_number (rng, model->cumulative[high]);
+  while (low < high)
+    {
+      uint64_t mid = low + (high - low) / 2;
+      if (model->cumulative[mid] > number)
+        {
+          high = mid;
+        }
+      else
+        {
+          low = mid + 1;
+        }
+    }
+  return model->successors[low];
+}
+
+/**
+ * Choose the next word from the longest context of the sentence that the
+ * model has with successors, backing off to shorter contexts down to the
+ * last word.
+ * @param model the model
+ * @param nodes nodes[k] is the node of the last k words, -1 if the model
+ * doesn't have it, for k in [1, order)
+ * @param rng the generator to draw from
+ * @return id of the chosen word, -1 if the last word has no successors
+ */
+int64_t get_next_ngram_word (const Model *model, const int64_t *nodes,
+                             Rng *rng)
+{
+  for (uint32_t length = model->header->order - 1; length > 1; --length)
+    {
+      if (nodes[length] != -1
+          && model->rows[nodes[length]] != model->rows[nodes[length] + 1])
+        {
+          return get_next_random_word (model, nodes[length], rng);
+        }
+    }
+  return get_next_random_word (model, nodes[1], rng);
+}
+
+/**
+ * Updates the nodes of the last words of the sentence after a word is
+ * added to it.
+ * @param model the model
+ * @param nodes nodes[k] is the node of the last k words, updated in place
+ * @param word_id id of the added word
+ */
+void advance_nodes (const Model *model, int64_t *nodes, uint32_t word_id)
+{
+  for (uint32_t length = model->header->order - 1; length > 1; --length)
+    {
+      nodes[length] = nodes[length - 1] == -1
+                      ? -1 : find_context (model, nodes[length - 1], word_id);
+    }
+  nodes[1] = word_id;
+}
+
+/**
+ * Receive model, generate random sentence out of it and append it to out.
+ * The sentence most have at least 2 words in it.
+ * @param model Model to use
+ * @param rng the generator to draw from
+ * @param out the buffer to write to
+ * @return Amount of words in printed sentence
+ */
+int generate_sentence (const Model *model, Rng *rng, OutputBuffer *out)
+{
+  int64_t temp = get_first_random_word (model, rng);
+  int num_of_words = 1;
+  if (temp == -1)
+    {
+      append_output (out, "\n", 1);
+      return 0;
+    }
+  int64_t nodes[MAX_ORDER] = {-1, -1, -1, -1};
+  advance_nodes (model, nodes, temp);
+  while (num_of_words <= MAX_WORDS_IN_SENTENCE_GENERATION)
+    {
+      append_output (out, word_text (model, temp), word_length (model, temp));
+      append_output (out, " ", 1);
+      temp = get_next_ngram_word (model, nodes, rng);
+      if (temp == -1)
+        {
+          break;
+        }
+      advance_nodes (model, nodes, temp);
+      num_of_words++;
+      if (ends_with_dot (model, temp) == 0)
+        {
+          append_output (out, word_text (model, temp),
+                         word_length (model, temp));
+          break;
+        }
+    }
+  append_output (out, "\n", 1);
+  return num_of_words;
+}
+
+/************ HEAP ************/
+/**
+ * Adds the key to the heap, doubling its memory when full.
+ * @param heap the heap
+ * @param key the key
+ */
+void push_heap (Heap *heap, uint64_t key)
+{
+  if (heap->size == heap->capacity)
+    {
+      heap->capacity = heap->capacity == 0 ? NGRAM_INITIAL_CAP
+                                           : heap->capacity * 2;
+      heap->keys = (uint64_t *) realloc (heap->keys, heap->capacity
+                                                     * sizeof (uint64_t));
+      if (heap->keys == NULL)
+        {
+          printf(ALOCATION_FAILURE);
+          exit (EXIT_FAILURE);
+        }
+    }
+  uint64_t i = heap->size++;
+  while (i > 0 && heap->keys[(i - 1) / 2] > key)
+    {
+      heap->keys[i] = heap->keys[(i - 1) / 2];
+      i = (i - 1) / 2;
+    }
+  heap->keys[i] = key;
+}
+
+/**
+ * Removes the smallest key of the heap.
+ * @param heap a heap that isn't empty
+ * @return the smallest key
+ */
+uint64_t pop_heap (Heap *heap)
+{
+  uint64_t top = heap->keys[0];
+  uint64_t key = heap->keys[--heap->size];
+  uint64_t i = 0;
+  while (2 * i + 1 < heap->size)
+    {
+      uint64_t child = 2 * i + 1;
+      if (child + 1 < heap->size && heap->keys[child + 1] < heap->keys[child])
+        {
+          child++;
+        }
+      if (heap->keys[child] >= key)
+        {
+          break;
+        }
+      heap->keys[i] = heap->keys[child];
+      i = child;
+    }
+  heap->keys[i] = key;
+  return top;
+}
+
+/************ CONSTRAINED GENERATION ************/
+/**
+ * Builds the graph of the model's words with every bigram reversed.
+ * @param model the model
+ * @param reverse_rows set to word_count + 1 offsets of the predecessors of
+ * every word
+ * @return the predecessors of the words, one row after the other
+ */
+uint32_t *reverse_bigrams (const Model *model, uint64_t **reverse_rows)
+{
+  uint32_t words = model->header->word_count;
+  uint64_t *rows = (uint64_t *) calloc ((size_t) words + 1,
+                                        sizeof (uint64_t));
+  uint64_t edges = model->rows[words] - model->rows[0];
+  uint32_t *predecessors = (uint32_t *) malloc ((edges + 1)
+                                                * sizeof (uint32_t));
+  if (rows == NULL || predecessors == NULL)
+    {
+      printf(ALOCATION_FAILURE);
+      exit (EXIT_FAILURE);
+    }
+  for (uint64_t e = model->rows[0]; e < model->rows[words]; ++e)
+    {
+      rows[model->successors[e] + 1]++;
+    }
+  for (uint32_t id = 0; id < words; ++id)
+    {
+      rows[id + 1] += rows[id];
+    }
+  // rows[id] is used as the next free place of id's row while placing, which
+  // leaves it at the start of id + 1's row; shifting back restores it
+  for (uint32_t id = 0; id < words; ++id)
+    {
+      for (uint64_t e = model->rows[id]; e < model->rows[id + 1]; ++e)
+        {
+          predecessors[rows[model->successors[e]]++] = id;
+        }
+    }
+  for (uint32_t id = words; id > 0; --id)
+    {
+      rows[id] = rows[id - 1];
+    }
+  rows[0] = 0;
+  *reverse_rows = rows;
+  return predecessors;
+}
+
+/**
+ * Finds the fewest characters from every word to a word with a dot with
+ * Dijkstra's algorithm over the reversed bigrams, starting from all the
+ * words with a dot at once. Words with a dot end the sentence, so nothing
+ * is searched past them, and nothing past max_chars is of use.
+ * @param model the model
+ * @param max_chars the most characters of a tweet
+ * @return the distance of every word, UNREACHABLE if more than max_chars
+ */
+uint32_t *find_distances (const Model *model, uint32_t max_chars)
+{
+  uint32_t words = model->header->word_count;
+  uint32_t *distance = (uint32_t *) malloc (((size_t) words + 1)
+                                            * sizeof (uint32_t));
+  if (distance == NULL)
+    {
+      printf(ALOCATION_FAILURE);
+      exit (EXIT_FAILURE);
+    }
+  uint64_t *reverse_rows = NULL;
+  uint32_t *predecessors = reverse_bigrams (model, &reverse_rows);
+  Heap heap = {NULL, 0, 0};
+  for (uint32_t id = 0; id < words; ++id)
+    {
+      distance[id] = ends_with_dot (model, id) == 0 ? 0 : UNREACHABLE;
+      if (distance[id] == 0)
+        {
+          push_heap (&heap, id);
+        }
+    }
+  while (heap.size > 0)
+    {
+      uint64_t key = pop_heap (&heap);
+      uint32_t id = (uint32_t) key;
+      if (key >> 32 != distance[id])
+        {
+          continue;
+        }
+      uint64_t cost = (key >> 32) + 1 + word_length (model, id);
+      if (cost > max_chars)
+        {
+          continue;
+        }
+      for (uint64_t e = reverse_rows[id]; e < reverse_rows[id + 1]; ++e)
+        {
+          uint32_t before = predecessors[e];
+          if (cost < distance[before] && ends_with_dot (model, before) == 1)
+            {
+              distance[before] = (uint32_t) cost;
+              push_heap (&heap, cost << 32 | before);
+            }
+        }
+    }
+  free (heap.keys);
+  free (predecessors);
+  free (reverse_rows);
+  return distance;
+}
+
+/**
+ * Precomputes what generating tweets of at most max_chars characters that
+ * end with a word with a dot needs.
+ * @param model the model
+ * @param max_chars the most characters of a tweet, without its prefix
+ * @return the constraint, on the heap
+ */
+Constraint *build_constraint (const Model *model, uint32_t max_chars)
+{
+  uint32_t words = model->header->word_count;
+  uint32_t nodes = words + model->header->context_count;
+  Constraint *constraint = (Constraint *) calloc (1, sizeof (Constraint));
+  uint32_t *distance = find_distances (model, max_chars);
+  if (constraint == NULL)
+    {
+      printf(ALOCATION_FAILURE);
+      exit (EXIT_FAILURE);
+    }
+  constraint->max_chars = max_chars;
+  constraint->need = (uint32_t *) malloc (((size_t) words + 1)
+                                          * sizeof (uint32_t));
+  constraint->max_need = (uint32_t *) calloc ((size_t) nodes + 1,
+                                              sizeof (uint32_t));
+  constraint->reachable = (uint64_t *) calloc (words / 64 + 1,
+                                               sizeof (uint64_t));
+  constraint->starters = (uint32_t *) malloc
+      (((size_t) model->header->starter_count + 1) * sizeof (uint32_t));
+  if (constraint->need == NULL || constraint->max_need == NULL
+      || constraint->reachable == NULL || constraint->starters == NULL)
+    {
+      printf(ALOCATION_FAILURE);
+      exit (EXIT_FAILURE);
+    }
+  for (uint32_t id = 0; id < words; ++id)
+    {
+      uint64_t need = (uint64_t) distance[id] + 1 + word_length (model, id);
+      constraint->need[id] = distance[id] == UNREACHABLE || need > max_chars
+                             ? UNREACHABLE : (uint32_t) need;
+      if (distance[id] != UNREACHABLE)
+        {
+          constraint->reachable[id / 64] |= 1ULL << (id % 64);
+        }
+    }
+  for (uint32_t node = 0; node < nodes; ++node)
+    {
+      for (uint64_t e = model->rows[node]; e < model->rows[node + 1]; ++e)
+        {
+          uint32_t need = constraint->need[model->successors[e]];
+          if (need > constraint->max_need[node])
+            {
+              constraint->max_need[node] = need;
+            }
+        }
+    }
+  for (uint32_t i = 0; i < model->header->starter_count; ++i)
+    {
+      uint32_t id = model->starters[i];
+      if (distance[id] != UNREACHABLE
+          && (uint64_t) distance[id] + word_length (model, id) <= max_chars)
+        {
+          constraint->starters[constraint->starter_count++] = id;
+        }
+    }
+  free (distance);
+  return constraint;
+}
+
+/**
+ * Frees the memory of the constraint.
+ * @param constraint the constraint, may be NULL
+ */
+void free_constraint (Constraint *constraint)
+{
+  if (constraint == NULL)
+    {
+      return;
+    }
+  free (constraint->need);
+  free (constraint->max_need);
+  free (constraint->reachable);
+  free (constraint->starters);
+  free (constraint);
+}
+
+/**
+ * Choose randomly the next word among the successors of the node that fit
+ * in what is left of the tweet, in proportion to their occurrences. When
+ * all of them fit, the node's alias table is used as is; otherwise the row
+ * is masked: words that can't reach a dot are skipped by the reachability
+ * bits, then words whose need doesn't fit.
+ * @param model the model
+ * @param constraint the constraint
+ * @param node the word or context to choose from
+ * @param budget characters left in the tweet
+ * @param rng the generator to draw from
+ * @return id of the chosen word, -1 if no successor fits
+ */
+int64_t get_next_constrained_word (const Model *model,
+                                   const Constraint *constraint,
+                                   uint32_t node, uint32_t budget, Rng *rng)
+{
+  uint64_t low = model->rows[node];
+  uint64_t high = model->rows[node + 1];
+  if (low == high)
+    {
+      return -1;
+    }
+  if (constraint->max_need[node] <= budget)
+    {
+      return get_next_random_word (model, node, rng);
+    }
+  uint32_t total = 0;
+  for (uint64_t e = low; e < high; ++e)
+    {
+      uint32_t id = model->successors[e];
+      if ((constraint->reachable[id / 64] >> (id % 64) & 1) == 1
+          && constraint->need[id] <= budget)
+        {
+          total += count_of (model, low, e);
+        }
+    }
+  if (total == 0)
+    {
+      return -1;
+    }
+  uint32_t number = get_random_number (rng, total);
+  for (uint64_t e = low;; ++e)
+    {
+      uint32_t id = model->successors[e];
+      if ((constraint->reachable[id / 64] >> (id % 64) & 1) == 0
+          || constraint->need[id] > budget)
+        {
+          continue;
+        }
+      uint32_t count = count_of (model, low, e);
+      if (number < count)
+        {
+          return id;
+        }
+      number -= count;
+    }
+}
+
+/**
+ * Generates a sentence of at most max_chars characters that ends with a
+ * word with a dot, and appends it to out. Every word is drawn only among
+ * the successors that can still end the sentence in time, from the longest
+ * context that has one, so no sentence is thrown away. The current word
+ * always has such a successor in its own row, which ends the back off.
+ * The sentence isn't cut at MAX_WORDS_IN_SENTENCE_GENERATION words, since
+ * max_chars bounds it.
+ * @param model Model to use
+ * @param constraint the constraint
+ * @param rng the generator to draw from
+ * @param out the buffer to write to
+ * @return Amount of words in printed sentence
+ */
+int generate_constrained_sentence (const Model *model,
+                                   const Constraint *constraint, Rng *rng,
+                                   OutputBuffer *out)
+{
+  if (constraint->starter_count == 0)
+    {
+      append_output (out, "\n", 1);
+      return 0;
+    }
+  uint32_t temp = constraint->starters[get_random_number
+      (rng, constraint->starter_count)];
+  uint32_t budget = constraint->max_chars - (uint32_t) word_length (model,
+                                                                    temp);
+  int num_of_words = 1;
+  int64_t nodes[MAX_ORDER] = {-1, -1, -1, -1};
+  advance_nodes (model, nodes, temp);
+  append_output (out, word_text (model, temp), word_length (model, temp));
+  while (ends_with_dot (model, temp) == 1)
+    {
+      int64_t next = -1;
+      for (uint32_t length = model->header->order - 1; length > 0
+                                                       && next == -1; --length)
+        {
+          if (nodes[length] != -1)
+            {
+              next = get_next_constrained_word (model, constraint,
+                                                nodes[length], budget, rng);
+            }
+        }
+      temp = (uint32_t) next;
+      budget -= 1 + (uint32_t) word_length (model, temp);
+      advance_nodes (model, nodes, temp);
+      num_of_words++;
+      append_output (out, " ", 1);
+      append_output (out, word_text (model, temp), word_length (model, temp));
+    }
+  append_output (out, "\n", 1);
+  return num_of_words;
+}
+
+/**
+ * This function calls the generate sentence function for every tweet in
+ * the given range of tweet numbers
+ * @param first number of the first tweet to generate
+ * @param last number of the last tweet to generate
+ * @param seed the seed of the run
+ * @param model holds the words to create sentences from
+ * @param constraint the constraint every tweet must meet, NULL for none
+ * @param out the buffer to write to
+ */
+void create_tweets (int first, int last, int seed, const Model *model,
+                    const Constraint *constraint, OutputBuffer *out)
+{
+  Rng rng;
+  for (int i = first; i <= last; ++i)
+    {
+      seed_rng (&rng, seed, i);
+      append_output (out, TWEET_PREFIX, sizeof (TWEET_PREFIX) - 1);
+      append_number (out, i);
+      append_output (out, TWEET_SUFFIX, sizeof (TWEET_SUFFIX) - 1);
+      if (constraint != NULL)
+        {
+          generate_constrained_sentence (model, constraint, &rng, out);
+        }
+      else
+        {
+          generate_sentence (model, &rng, out);
+        }
+    }
+}
+
+/************ PARALLEL GENERATION ************/
+/**
+ * @struct GenerationTask - a range of tweets generated by one thread.
+ * @param out a memory only buffer the tweets are collected in.
+ */
+typedef struct GenerationTask {
+    int first;
+    int last;
+    int seed;
+    const Model *model;
+    const Constraint *constraint;
+    OutputBuffer out;
+} GenerationTask;
+
+/**
+ * Thread entry point: generates the task's tweets into its buffer.
+ * @param arg the GenerationTask
+ * @return NULL
+ */
+void *generate_part (void *arg)
+{
+  GenerationTask *task = (GenerationTask *) arg;
+  create_tweets (task->first, task->last, task->seed, task->model,
+                 task->constraint, &task->out);
+  return NULL;
+}
+
+/**
+ * Generates the tweets with the given number of threads. The tweets are
+ * generated in rounds of GENERATION_BATCH tweets per thread, and the
+ * threads' buffers are written in the order of their tweets at the end of
+ * every round, so the output is the same for any number of threads.
+ * @param num_of_tweets number of sentences to generate
+ * @param seed the seed of the run
+ * @param model holds the words to create sentences from
+ * @param constraint the constraint every tweet must meet, NULL for none
+ * @param threads number of threads to use
+ * @param out the buffer to write to
+ */
+void create_tweets_parallel (int num_of_tweets, int seed, const Model *model,
+                             const Constraint *constraint, int threads,
+                             OutputBuffer *out)
+{
+  pthread_t workers[MAX_THREADS];
+  GenerationTask tasks[MAX_THREADS];
+  for (int i = 0; i < threads; ++i)
+    {
+      tasks[i] = (GenerationTask) {0, 0, seed, model, constraint,
+                                   {NULL, 0, 0, -1, 0}};
+    }
+  int next = 1;
+  while (next <= num_of_tweets)
+    {
+      for (int i = 0; i < threads; ++i)
+        {
+          tasks[i].first = next;
+          tasks[i].last = num_of_tweets - next < GENERATION_BATCH
+                          ? num_of_tweets : next + GENERATION_BATCH - 1;
+          next = tasks[i].last + 1;
+          if (pthread_create (&workers[i], NULL, generate_part, &tasks[i])
+              != 0)
+            {
+              generate_part (&tasks[i]);
+              workers[i] = pthread_self ();
+            }
+        }
+      flush_output (out);
+      for (int i = 0; i < threads; ++i)
+        {
+          if (pthread_equal (workers[i], pthread_self ()) == 0)
+            {
+              pthread_join (workers[i], NULL);
+            }
+          write_output (out, tasks[i].out.data, tasks[i].out.size);
+          tasks[i].out.size = 0;
+        }
+    }
+  for (int i = 0; i < threads; ++i)
+    {
+      free (tasks[i].out.data);
+    }
+}
@@ -0,0 +1,163 @@
+#ifndef TWEETS_GENERATION_H_
+#define TWEETS_GENERATION_H_
+
+#include <stdint.h>
+#include "tweetsModel.h"
+#include "tweetsOutput.h"
+
+/*
+ * Generating tweets from a model: the random generator, drawing the words,
+ * the tweets of at most max_chars characters, and the threads that
+ * generate in parallel.
+ */
+
+#define MAX_WORDS_IN_SENTENCE_GENERATION 20
+
+/**
+ * @struct Rng - the state of the 64 bit generator tweets are drawn with.
+ * The generator is xoshiro256** by default, or wyrand when compiled with
+ * RNG_WYRAND defined; both are seeded by seed_rng and drawn by rng_next.
+ * Every tweet is generated with its own generator, seeded from the seed of
+ * the run and the tweet's number, so tweets don't depend on each other and
+ * come out the same whichever thread generates them.
+ */
+typedef struct Rng {
+    uint64_t state[4];
+} Rng;
+
+/**
+ * Seeds the generator of a tweet.
+ * @param rng the generator
+ * @param seed the seed of the run
+ * @param tweet the number of the tweet
+ */
+void seed_rng (Rng *rng, int seed, uint32_t tweet);
+
+/**
+ * Choose randomly the next word from the given model, drawn uniformly.
+ * The function won't return a word that end's in full stop '.' (Nekuda).
+ * Words are drawn from the model's starters array, which holds exactly
+ * the words that don't end with a dot, so a single draw is enough.
+ * @param model Model to choose a word from
+ * @param rng the generator to draw from
+ * @return id of the chosen word, -1 if there is no such word
+ */
+int64_t get_first_random_word (const Model *model, Rng *rng);
+
+/**
+ * Choose randomly the next word. Depend on it's occurrence frequency
+ * as a successor of the given node.
+ * The word is drawn from the alias table of the node's row, which reads one
+ * entry of the table and the total of the row whatever the row's length.
+ * @param model the model
+ * @param node the word or context to choose from
+ * @param rng the generator to draw from
+ * @return id of the chosen word, -1 if the node has no successors
+ */
+int64_t get_next_random_word (const Model *model, uint32_t node, Rng *rng);
+
+/**
+ * Chooses the next word like get_next_random_word, with a binary search
+ * over the running sums of the node's row instead of its alias table.
+ * A draw costs O(log successors) reads spread over the row. Kept to
+ * compare the two when benchmarking.
+ * @param model the model
+ * @param node the word or context to choose from
+ * @param rng the generator to draw from
+ * @return id of the chosen word, -1 if the node has no successors
+ */
+int64_t get_next_cumulative_word (const Model *model, uint32_t node,
+                                  Rng *rng);
+
+/**
+ * @struct Heap - a binary min heap of 64 bit keys. Pairs of 32 bit numbers
+ * are packed into a key with the one to order by in the high half.
+ */
+typedef struct Heap {
+    uint64_t *keys;
+    uint64_t size;
+    uint64_t capacity;
+} Heap;
+
+/**
+ * Adds the key to the heap, doubling its memory when full.
+ * @param heap the heap
+ * @param key the key
+ */
+void push_heap (Heap *heap, uint64_t key);
+
+/**
+ * Removes the smallest key of the heap.
+ * @param heap a heap that isn't empty
+ * @return the smallest key
+ */
+uint64_t pop_heap (Heap *heap);
+
+/**
+ * @struct Constraint - what generating tweets of at most max_chars
+ * characters that end with a word that ends with a dot needs.
+ * A word's need is the fewest characters a sentence needs after the words
+ * before it to take the word and still end with a dot: the space before
+ * it, the word and the fewest characters from it to a word with a dot.
+ * @param need the need of every word, UNREACHABLE if it is more than
+ * max_chars or no word with a dot can follow it.
+ * @param max_need the largest need of the successors of every node, so a
+ * node whose max_need fits what is left of a tweet samples without a mask.
+ * @param reachable bit i is set if a word with a dot can follow word i
+ * within max_chars characters.
+ * @param starters the starters a whole tweet can start with.
+ */
+typedef struct Constraint {
+    uint32_t max_chars;
+    uint32_t *need;
+    uint32_t *max_need;
+    uint64_t *reachable;
+    uint32_t *starters;
+    uint32_t starter_count;
+} Constraint;
+
+/**
+ * Precomputes what generating tweets of at most max_chars characters that
+ * end with a word with a dot needs.
+ * @param model the model
+ * @param max_chars the most characters of a tweet, without its prefix
+ * @return the constraint, on the heap
+ */
+Constraint *build_constraint (const Model *model, uint32_t max_chars);
+
+/**
+ * Frees the memory of the constraint.
+ * @param constraint the constraint, may be NULL
+ */
+void free_constraint (Constraint *constraint);
+
+/**
+ * This function calls the generate sentence function for every tweet in
+ * the given range of tweet numbers
+ * @param first number of the first tweet to generate
+ * @param last number of the last tweet to generate
+ * @param seed the seed of the run
+ * @param model holds the words to create sentences from
+ * @param constraint the constraint every tweet must meet, NULL for none
+ * @param out the buffer to write to
+ */
+void create_tweets (int first, int last, int seed, const Model *model,
+                    const Constraint *constraint, OutputBuffer *out);
+
+/**
+ * Generates the tweets with the given number of threads. The tweets are
+ * generated in rounds of GENERATION_BATCH tweets per thread, and the
+ * threads' buffers are written in the order of their tweets at the end of
+ * every round, so the output is the same for any number of threads.
+ * @param num_of_tweets number of sentences to generate
+ * @param seed the seed of the run
+ * @param model holds the words to create sentences from
+ * @param constraint the constraint every tweet must meet, NULL for none
+ * @param threads number of threads to use
+ * @param out the buffer to write to
+ */
+void create_tweets_parallel (int num_of_tweets, int seed, const Model *model,
+                             const Constraint *constraint, int threads,
+                             OutputBuffer *out);
+
+#endif //TWEETS_GENERATION_H_
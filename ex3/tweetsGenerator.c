@@ -1,443 +1,692 @@
+#define _POSIX_C_SOURCE 200809L
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include "tweetsProtocol.h"
+#include "tweetsCommon.h"
+#include "tweetsCorpus.h"
+#include "tweetsUpdate.h"
+#include "tweetsStats.h"
+#include "tweetsPruning.h"
+#include "tweetsServer.h"
 
-#define MAX_WORDS_IN_SENTENCE_GENERATION 20
-#define MAX_WORD_LENGTH 100
-#define MAX_SENTENCE_LENGTH 1000
-#define SAME 0
-#define TWEET_ITR "Tweet %d: "
 #define USAGE_ERROR "Usage: Input should be <seed><number of tweets><path to \
 tweets file><number of words to reads from file>"
-#define ALOCATION_FAILURE "Allocation failure: Too much junk on the computer, \
-free some space!"
 #define FILE_ERROR "Error: File path is wrong!"
-#define CORRECT_NUM_4 4
-#define CORRECT_NUM_5 5
-#define BASE 10
-
-typedef struct WordStruct {
-    char *word;
-    int number_of_occurrence;
-    int prob_list_size;
-    int prob_list_size_with_duplicats;
-    struct WordProbability *prob_list;
-} WordStruct;
-
-typedef struct WordProbability {
-    struct WordStruct *word_struct_ptr;
-    int num_of_occurrnces;
-
-} WordProbability;
-
-/************ LINKED LIST ************/
-typedef struct Node {
-    WordStruct *data;
-    struct Node *next;
-} Node;
-
-typedef struct LinkList {
-    Node *first;
-    Node *last;
-    int size;
-} LinkList;
+#define MODEL_ERROR "Error: Model file is invalid!"
+#define SAVE_ERROR "Error: Can't write the model file!"
+#define OUTPUT_ERROR "Error: Can't write the output file!"
+#define LOAD_USAGE_ERROR "Usage: Input should be <seed><number of tweets> \
+--load-model <path to model file>"
+#define RUN_ARGUMENTS 2
+#define MAX_POSITIONALS 4
+#define BENCH_FLAG "--bench"
+#define THREADS_FLAG "--threads"
+#define SAVE_MODEL_FLAG "--save-model"
+#define LOAD_MODEL_FLAG "--load-model"
+#define ORDER_FLAG "--order"
+#define OUTPUT_FLAG "--output"
+#define APPEND_FLAG "--append"
+#define SERVE_FLAG "--serve"
+#define SERVE_ERROR "Error: Can't listen on the socket!"
+#define SERVE_USAGE_ERROR "Usage: Input should be <path to tweets file> \
+optional - <number of words to read> --serve <path to socket>"
+#define SERVE_LOAD_USAGE_ERROR "Usage: Input should be --load-model <path to \
+model file> --serve <path to socket>"
+#define STATS_FLAG "--stats"
+#define STATS_TEXT_NAME "text"
+#define STATS_JSON_NAME "json"
+#define MAX_CHARS_FLAG "--max-chars"
+#define COUNT_FLAG "--count"
+#define COUNT_WORDS_TITLE "Words:\n"
+#define COUNT_BIGRAMS_TITLE "Bigrams:\n"
+#define COUNT_REPORT "Counted %llu words in %.3f seconds (%.0f words/sec, \
+%.1f MB/s)\n"
+#define COUNT_USAGE_ERROR "Usage: Input should be <path to file> optional - \
+<number of words to read> --count <number of top words>"
+#define MIN_COUNT_FLAG "--min-count"
+#define MAX_WORDS_FLAG "--max-words"
+#define BENCH_REPORT "Generated %d tweets in %.3f seconds (%.0f tweets/sec)\n"
+#define UPDATE_REPORT "Added %d words, refreshed %d of %d rows in %.3f \
+seconds\n"
+#define SAMPLING_REPORT "Sampled %llu words with %s in %.3f seconds (%.1f \
+ns/word)\n"
 
+/************ COUNTING ************/
 /**
- * Add data to new node at the end of the given link list.
- * @param link_list Link list to add data to
- * @param data pointer to dynamically allocated data
- * @return 0 on success, 1 otherwise
+ * Finds the top entries by count with a min heap of at most top keys, so
+ * the memory is O(top) whatever the number of entries. A key packs the
+ * count with the complement of the entry's index, so of equal counts the
+ * entry seen first ranks higher.
+ * @param counts the counts of the entries
+ * @param size number of entries
+ * @param top number of entries to find
+ * @param heap an empty heap, left holding the keys of the top entries
  */
-int add (LinkList *link_list, WordStruct *data)
+void find_top (const uint32_t *counts, uint32_t size, uint32_t top,
+               Heap *heap)
 {
-  Node *new_node = malloc (sizeof (Node));
-  if (new_node == NULL)
+  for (uint32_t i = 0; i < size && top > 0; ++i)
     {
-      return 1;
+      uint64_t key = (uint64_t) counts[i] << 32 | (UINT32_MAX - i);
+      if (heap->size < top)
+        {
+          push_heap (heap, key);
+        }
+      else if (key > heap->keys[0])
+        {
+          pop_heap (heap);
+          push_heap (heap, key);
+        }
     }
-  *new_node = (Node) {data, NULL};
+}
 
-  if (link_list->first == NULL)
+/**
+ * Empties the heap of find_top into the order of the entries' ranks.
+ * @param heap the heap
+ * @return the number of entries, the indices of the entries from the
+ * highest rank down are left in heap->keys
+ */
+uint64_t rank_top (Heap *heap)
+{
+  uint64_t size = heap->size;
+  uint64_t *ranked = (uint64_t *) malloc ((size + 1) * sizeof (uint64_t));
+  if (ranked == NULL)
     {
-      link_list->first = new_node;
-      link_list->last = new_node;
+      printf(ALOCATION_FAILURE);
+      exit (EXIT_FAILURE);
     }
-  else
+  for (uint64_t i = size; i > 0; --i)
     {
-      link_list->last->next = new_node;
-      link_list->last = new_node;
+      ranked[i - 1] = UINT32_MAX - (uint32_t) pop_heap (heap);
     }
-
-  link_list->size++;
-  return 0;
+  free (heap->keys);
+  heap->keys = ranked;
+  heap->size = size;
+  return size;
 }
 
-/*************************************/
-int dot_at_end (WordStruct *prev_word);
-
-void
-load_word (LinkList *dictionary, WordStruct *temp_word, char *word,
-           int new_word);
-
-WordStruct *check_word (LinkList *dictionary, char *word);
-
-WordStruct *memory_allocation (WordStruct *word, int word_or_prob_list);
-
 /**
- * Get random number between 0 and max_number [0, max_number).
- * @param max_number
- * @return Random number
+ * Writes the top words and bigrams of the counted dictionary, one per line
+ * after its count, from the most frequent down.
+ * @param dictionary a count_only dictionary
+ * @param top number of words and of bigrams to write
+ * @param out the buffer to write to
  */
-int get_random_number (int max_number)
+void write_top (const Dictionary *dictionary, uint32_t top, OutputBuffer *out)
 {
-  int number = rand () % max_number;
-  return number;
+  uint32_t *counts = (uint32_t *) malloc ((dictionary->size + 1)
+                                          * sizeof (uint32_t));
+  if (counts == NULL)
+    {
+      printf(ALOCATION_FAILURE);
+      exit (EXIT_FAILURE);
+    }
+  for (int id = 0; id < dictionary->size; ++id)
+    {
+      counts[id] = dictionary->words[id].number_of_occurrence;
+    }
+  Heap heap = {NULL, 0, 0};
+  find_top (counts, dictionary->size, top, &heap);
+  free (counts);
+  append_output (out, COUNT_WORDS_TITLE, sizeof (COUNT_WORDS_TITLE) - 1);
+  for (uint64_t i = 0, size = rank_top (&heap); i < size; ++i)
+    {
+      const WordStruct *word = &dictionary->words[heap.keys[i]];
+      append_number (out, word->number_of_occurrence);
+      append_output (out, " ", 1);
+      append_output (out, word->word, word->length);
+      append_output (out, "\n", 1);
+    }
+  free (heap.keys);
+  heap = (Heap) {NULL, 0, 0};
+  find_top (dictionary->ngrams.counts, dictionary->ngrams.size, top, &heap);
+  append_output (out, COUNT_BIGRAMS_TITLE, sizeof (COUNT_BIGRAMS_TITLE) - 1);
+  for (uint64_t i = 0, size = rank_top (&heap); i < size; ++i)
+    {
+      uint64_t key = dictionary->ngrams.keys[heap.keys[i]];
+      const WordStruct *first = &dictionary->words[key >> 32];
+      const WordStruct *second = &dictionary->words[(uint32_t) key];
+      append_number (out, dictionary->ngrams.counts[heap.keys[i]]);
+      append_output (out, " ", 1);
+      append_output (out, first->word, first->length);
+      append_output (out, " ", 1);
+      append_output (out, second->word, second->length);
+      append_output (out, "\n", 1);
+    }
+  free (heap.keys);
 }
 
 /**
- * Choose randomly the next word from the given dictionary, drawn uniformly.
- * The function won't return a word that end's in full stop '.' (Nekuda).
- * @param dictionary Dictionary to choose a word from
- * @return WordStruct of the chosen word
+ * @struct Options - the optional flags of the program.
+ * @param bench 1 to report the generation throughput.
+ * @param threads number of threads to read the corpus and generate with.
+ * @param save_model path to write the model to, NULL if not given.
+ * @param load_model path to read the model from instead of a corpus, NULL if
+ * not given.
+ * @param order the order of the Markov chain to build.
+ * @param output path to write the tweets to, NULL for stdout.
+ * @param append path of a corpus file to add to the model, NULL if not given.
+ * @param pruning the words and successors to keep in the model.
+ * @param serve path of the socket to serve tweets on, NULL to print them.
+ * @param stats how to report the stats of the run, if at all.
+ * @param max_chars the most characters of a tweet that must end with a word
+ * with a dot, 0 to generate tweets freely.
+ * @param count number of top words and bigrams to count instead of
+ * generating tweets, 0 to generate them.
+ * @param positionals the arguments that aren't flags, in order, of which
+ * only the first MAX_POSITIONALS are kept.
+ * @param positional_count number of arguments that aren't flags, after the
+ * program itself.
+ */
+typedef struct Options {
+    int bench;
+    int threads;
+    const char *save_model;
+    const char *load_model;
+    int order;
+    const char *output;
+    const char *append;
+    Pruning pruning;
+    const char *serve;
+    StatsFormat stats;
+    int max_chars;
+    int count;
+    char *positionals[MAX_POSITIONALS];
+    int positional_count;
+} Options;
+
+/**
+ * reads the optional flags of the arguments into options, and collects the
+ * other arguments, whose meaning depends on the mode the flags select
+ * @param argc number of arguments
+ * @param argv the arguments
+ * @param options the options to fill
+ * @return 0 on success, 1 if a flag is malformed
  */
-WordStruct *get_first_random_word (LinkList *dictionary)
+int parse_options (int argc, char *argv[], Options *options)
 {
-  struct Node *temp = dictionary->first;
-  int word_number = get_random_number (dictionary->size);
-  while (1 != 0)
+  char *ptr = NULL;
+  *options = (Options) {0, 1, NULL, NULL, MIN_ORDER, NULL, NULL, {1, 0},
+                          NULL, STATS_NONE, 0, 0, {NULL}, 0};
+  for (int i = 1; i < argc; ++i)
     {
-      for (int i = 0; i < word_number; ++i)
+      if (strcmp (argv[i], BENCH_FLAG) == SAME)
         {
-          temp = temp->next;
+          options->bench = 1;
+          continue;
         }
-      if (dot_at_end (temp->data) == 1)
+      if (strcmp (argv[i], THREADS_FLAG) == SAME)
         {
-          break;
+          if (i + 1 == argc)
+            {
+              return 1;
+            }
+          options->threads = strtol (argv[++i], &ptr, BASE);
+          if (*ptr != '\0' || options->threads < 1
+              || options->threads > MAX_THREADS)
+            {
+              return 1;
+            }
+          continue;
         }
-      word_number = get_random_number (dictionary->size);
-      temp = dictionary->first;
-    }
-  return temp->data;
-}
-
-/**
- * Choose randomly the next word. Depend on it's occurrence frequency
- * in word_struct_ptr->WordProbability.
- * @param word_struct_ptr WordStruct to choose from
- * @return WordStruct of the chosen word
- */
-WordStruct *get_next_random_word (WordStruct *word_struct_ptr)
-{
-  int word_count = 0;
-  int number = get_random_number (word_struct_ptr->
-      prob_list_size_with_duplicats);
-  WordProbability *temp = word_struct_ptr->prob_list;
-  for (int i = 0; i < number; ++i)
-    {
-      word_count += 1;
-      if (word_count >= temp->num_of_occurrnces)
+      if (strcmp (argv[i], ORDER_FLAG) == SAME)
+        {
+          if (i + 1 == argc)
+            {
+              return 1;
+            }
+          options->order = strtol (argv[++i], &ptr, BASE);
+          if (*ptr != '\0' || options->order < MIN_ORDER
+              || options->order > MAX_ORDER)
+            {
+              return 1;
+            }
+          continue;
+        }
+      if (strcmp (argv[i], STATS_FLAG) == SAME)
+        {
+          if (i + 1 == argc)
+            {
+              return 1;
+            }
+          i++;
+          if (strcmp (argv[i], STATS_TEXT_NAME) == SAME)
+            {
+              options->stats = STATS_TEXT;
+            }
+          else if (strcmp (argv[i], STATS_JSON_NAME) == SAME)
+            {
+              options->stats = STATS_JSON;
+            }
+          else
+            {
+              return 1;
+            }
+          continue;
+        }
+      if (strcmp (argv[i], MIN_COUNT_FLAG) == SAME
+          || strcmp (argv[i], MAX_WORDS_FLAG) == SAME
+          || strcmp (argv[i], MAX_CHARS_FLAG) == SAME
+          || strcmp (argv[i], COUNT_FLAG) == SAME)
+        {
+          if (i + 1 == argc)
+            {
+              return 1;
+            }
+          int *limit = strcmp (argv[i], MIN_COUNT_FLAG) == SAME
+                       ? &options->pruning.min_count
+                       : strcmp (argv[i], MAX_WORDS_FLAG) == SAME
+                         ? &options->pruning.max_words
+                         : strcmp (argv[i], MAX_CHARS_FLAG) == SAME
+                           ? &options->max_chars : &options->count;
+          *limit = strtol (argv[++i], &ptr, BASE);
+          if (*ptr != '\0' || *limit < 1)
+            {
+              return 1;
+            }
+          continue;
+        }
+      if (strcmp (argv[i], SAVE_MODEL_FLAG) == SAME
+          || strcmp (argv[i], LOAD_MODEL_FLAG) == SAME
+          || strcmp (argv[i], OUTPUT_FLAG) == SAME
+          || strcmp (argv[i], APPEND_FLAG) == SAME
+          || strcmp (argv[i], SERVE_FLAG) == SAME)
+        {
+          if (i + 1 == argc)
+            {
+              return 1;
+            }
+          if (strcmp (argv[i], SAVE_MODEL_FLAG) == SAME)
+            {
+              options->save_model = argv[++i];
+            }
+          else if (strcmp (argv[i], LOAD_MODEL_FLAG) == SAME)
+            {
+              options->load_model = argv[++i];
+            }
+          else if (strcmp (argv[i], OUTPUT_FLAG) == SAME)
+            {
+              options->output = argv[++i];
+            }
+          else if (strcmp (argv[i], APPEND_FLAG) == SAME)
+            {
+              options->append = argv[++i];
+            }
+          else
+            {
+              options->serve = argv[++i];
+            }
+          continue;
+        }
+      if (options->positional_count < MAX_POSITIONALS)
         {
-          word_count = 0;
-          temp++;
+          options->positionals[options->positional_count] = argv[i];
         }
+      options->positional_count++;
     }
-  return temp->word_struct_ptr;
+  return 0;
 }
 
 /**
- * Receive dictionary, generate and print to stdout random sentence out of it.
- * The sentence most have at least 2 words in it.
- * @param dictionary Dictionary to use
- * @return Amount of words in printed sentence
+ * @struct Arguments - the positional arguments of the program, which depend
+ * on its mode.
+ * @param seed, num_of_tweets the run to generate, not given to the server,
+ * which takes them from every request, nor to counting.
+ * @param corpus path to the corpus file, NULL when a model is loaded.
+ * @param words_to_read number of words to read from the corpus, -1 for the
+ * entire file.
  */
-int generate_sentence (LinkList *dictionary)
-{
-  WordStruct *temp = get_first_random_word (dictionary);
-  int num_of_words = 1;
-  while (num_of_words <= MAX_WORDS_IN_SENTENCE_GENERATION)
-    {
-      printf ("%s ", temp->word);
-      temp = get_next_random_word (temp);
-      num_of_words++;
-      if (dot_at_end (temp) == 0)
-        {
-          printf ("%s", temp->word);
-          break;
-        }
-    }
-  printf ("\n");
-  return num_of_words;
-}
+typedef struct Arguments {
+    int seed;
+    int num_of_tweets;
+    const char *corpus;
+    int words_to_read;
+} Arguments;
 
 /**
- * This function calls the generate sentence function as many times as the
- * user wants
- * @param num_of_tweets number of sentences to generate
- * @param dictionary holds the words to create sentences from
+ * reads the positional arguments of counting: the corpus and optionally the
+ * number of words to read from it, and nothing else. Counting builds no
+ * model, so the flags of a model, of serving and of generating are refused
+ * too, instead of being ignored.
+ * @param options the optional flags, with the positional arguments
+ * @param arguments the arguments to fill
+ * @return 0 on success, 1 otherwise, after printing the usage
  */
-void create_tweets (int num_of_tweets, LinkList *dictionary)
+int parse_count_arguments (const Options *options, Arguments *arguments)
 {
-  for (int i = 1; i <= num_of_tweets; ++i)
+  char *ptr = NULL;
+  int given = options->positional_count;
+  int refused = (given != 1 && given != 2) || options->load_model != NULL
+                || options->save_model != NULL || options->append != NULL
+                || options->serve != NULL || options->max_chars > 0
+                || options->pruning.min_count > 1
+                || options->pruning.max_words > 0;
+  if (refused == 0 && given == 2)
+    {
+      arguments->words_to_read = strtol (options->positionals[1], &ptr,
+                                         BASE);
+      refused = *ptr != '\0' || arguments->words_to_read < 0;
+    }
+  if (refused == 1)
     {
-      printf (TWEET_ITR, i);
-      generate_sentence (dictionary);
+      printf (COUNT_USAGE_ERROR);
+      return 1;
     }
+  arguments->corpus = options->positionals[0];
+  return 0;
 }
 
 /**
- * This function checks if the next word already in the probability list of
- * the current word
- * @param curr_word the current word
- * @param next_word the next word
- * @return pointer to word if the word exists else NULL
+ * reads the positional arguments of the mode the options select, printing
+ * the usage of that mode if there are too few or too many of them:
+ * <seed><number of tweets>, unless serving, then the corpus and optionally
+ * the number of words to read from it, unless a model is loaded
+ * @param options the optional flags, with the positional arguments
+ * @param arguments the arguments to fill
+ * @return 0 on success, 1 otherwise
  */
-WordProbability *check_if_exists (WordStruct *curr_word, WordStruct *next_word)
+int parse_arguments (const Options *options, Arguments *arguments)
 {
-  WordProbability *temp = curr_word->prob_list;
-  int size = 0;
-  while (temp != NULL && size < curr_word->prob_list_size)
+  char *const *positionals = options->positionals;
+  char *ptr = NULL;
+  *arguments = (Arguments) {0, 0, NULL, -1};
+  if (options->count > 0)
+    {
+      return parse_count_arguments (options, arguments);
+    }
+  const char *usage = options->serve != NULL
+                      ? (options->load_model != NULL ? SERVE_LOAD_USAGE_ERROR
+                                                     : SERVE_USAGE_ERROR)
+                      : options->load_model != NULL ? LOAD_USAGE_ERROR
+                                                    : USAGE_ERROR;
+  int first = 0;
+  if (options->serve == NULL)
     {
-      if (strcmp (temp->word_struct_ptr->word, next_word->word) == 0)
+      if (options->positional_count < RUN_ARGUMENTS)
         {
-          return temp;
+          printf ("%s", usage);
+          return 1;
         }
-      size++;
-      temp++;
+      arguments->seed = strtol (positionals[0], &ptr, BASE);
+      arguments->num_of_tweets = strtol (positionals[1], &ptr, BASE);
+      first = RUN_ARGUMENTS;
+    }
+  int given = options->positional_count - first;
+  if (options->load_model != NULL)
+    {
+      if (given != 0)
+        {
+          printf ("%s", usage);
+          return 1;
+        }
+      return 0;
+    }
+  if (given != 1 && given != 2)
+    {
+      printf ("%s", usage);
+      return 1;
+    }
+  arguments->corpus = positionals[first];
+  if (given == 2)
+    {
+      arguments->words_to_read = strtol (positionals[first + 1], &ptr, BASE);
     }
-  return NULL;
+  return 0;
 }
 
 /**
- * Gets 2 WordStructs. If second_word in first_word's prob_list,
- * update the existing probability value.
- * Otherwise, add the second word to the prob_list of the first word.
- * @param first_word
- * @param second_word
- * @return 0 if already in list, 1 otherwise.
+ * generates the tweets, and reports the generation throughput to stderr
+ * when benchmarking
+ * @param num_of_tweets number of sentences to generate
+ * @param seed the seed of the run
+ * @param model holds the words to create sentences from
+ * @param constraint the constraint every tweet must meet, NULL for none
+ * @param threads number of threads to generate with
+ * @param out the buffer to write to
+ * @param bench 1 to report the throughput, 0 otherwise
+ * @return the seconds it took to generate and write the tweets
  */
-int
-add_word_to_probability_list (WordStruct *first_word, WordStruct *second_word)
+double run_generation (int num_of_tweets, int seed, const Model *model,
+                       const Constraint *constraint, int threads,
+                       OutputBuffer *out, int bench)
 {
-  WordProbability *pos = check_if_exists (first_word, second_word);
-  if (first_word->prob_list == NULL)
-    {
-      memory_allocation (first_word, 1);
-      first_word->prob_list->word_struct_ptr = second_word;
-      first_word->prob_list->num_of_occurrnces = 1;
-      first_word->prob_list_size = 1;
-      first_word->prob_list_size_with_duplicats = 1;
-      return 1;
+  double start = get_time ();
+  if (threads > 1)
+    {
+      create_tweets_parallel (num_of_tweets, seed, model, constraint,
+                              threads, out);
     }
-  if (first_word->prob_list != NULL && pos == NULL)
+  else
     {
-      memory_allocation (first_word, 2);
-      first_word->prob_list[first_word->prob_list_size].word_struct_ptr =
-          second_word;
-      first_word->prob_list[first_word->prob_list_size].num_of_occurrnces = 1;
-      first_word->prob_list_size += 1;
-      first_word->prob_list_size_with_duplicats += 1;
-      return 0;
+      create_tweets (1, num_of_tweets, seed, model, constraint, out);
     }
-  pos->num_of_occurrnces += 1;
-  first_word->prob_list_size_with_duplicats += 1;
-  return 1;
-
+  flush_output (out);
+  double elapsed = get_time () - start;
+  if (bench == 1)
+    {
+      fprintf (stderr, BENCH_REPORT, num_of_tweets, elapsed,
+               elapsed > 0 ? num_of_tweets / elapsed : 0);
+    }
+  return elapsed;
 }
 
 /**
- * Read word from the given file. Add every unique word to the dictionary.
- * Also, at every iteration, update the prob_list of the previous word with
- * the value of the current word.
- * @param fp File pointer
- * @param words_to_read Number of words to read from file.
- *                      If value is bigger than the file's word count,
- *                      or if words_to_read == -1 than read entire file.
- * @param dictionary Empty dictionary to fill
+ * Times the sampling step alone and reports it to stderr: walks the chain
+ * of words for the given number of draws, starting over from a random
+ * starter at the end of every sentence, without writing anything.
+ * @param model the model
+ * @param seed the seed of the run
+ * @param draws number of words to draw
+ * @param next_word the way to draw the next word
+ * @param name the name of the way, for the report
  */
-void fill_dictionary (FILE *fp, int words_to_read, LinkList *dictionary)
+void bench_sampling (const Model *model, int seed, uint64_t draws,
+                     int64_t (*next_word) (const Model *, uint32_t, Rng *),
+                     const char *name)
 {
-  char *word = NULL;
-  char line[MAX_SENTENCE_LENGTH];
-  int word_read = 0;
-  WordStruct *temp_word = NULL;
-  WordStruct *prev_word = NULL;
-  while (fgets (line, MAX_SENTENCE_LENGTH, fp) != NULL)
-    {
-      //line[strcspn (line, "\n")] = 0;
-      word = strtok (line, " \n");
-      while (word_read != words_to_read)
+  Rng rng;
+  seed_rng (&rng, seed, 0);
+  int64_t word = -1;
+  double start = get_time ();
+  for (uint64_t i = 0; i < draws; ++i)
+    {
+      if (word == -1 || ends_with_dot (model, word) == 0)
         {
-          temp_word = check_word (dictionary, word);
-          if (temp_word == NULL)
-            {
-              temp_word = memory_allocation (NULL, 0);
-              load_word (dictionary, temp_word, word, 1);
-              word_read++;
-            }
-          else
+          word = get_first_random_word (model, &rng);
+          if (word == -1)
             {
-              load_word (dictionary, temp_word, word, 0);
-              word_read++;
-            }
-          if (dot_at_end (prev_word) == 1)
-            {
-              add_word_to_probability_list (prev_word, temp_word);
-            }
-          prev_word = temp_word;
-          word = strtok (NULL, " \n");
-          if (word == NULL)
-            {
-              prev_word = NULL;
-              temp_word = NULL;
-              break;
+              return;
             }
         }
+      word = next_word (model, word, &rng);
     }
+  double elapsed = get_time () - start;
+  fprintf (stderr, SAMPLING_REPORT, (unsigned long long) draws, name,
+           elapsed, draws == 0 ? 0 : elapsed * 1e9 / (double) draws);
 }
 
 /**
- * checks if there is a dot at the end of the world
- * @param prev_word the word to check
- * @return 0 if ends with a dot else 1
+ * Reads the corpus file into a dictionary and freezes it to a model.
+ * @param path path to the corpus file
+ * @param words_to_read number of words to read, -1 for the entire file
+ * @param threads number of threads to read the file with
+ * @param order the order of the Markov chain
+ * @param pruning the words and successors to keep
+ * @param stats the stats the phases are added to
+ * @return the model, NULL if the file can't be opened
  */
-int dot_at_end (WordStruct *prev_word)
+Model *build_model (const char *path, int words_to_read, int threads,
+                    int order, const Pruning *pruning, Stats *stats)
 {
-  if (prev_word == NULL)
-    {
-      return 0;
-    }
-  int dot_loc = strlen (prev_word->word) - 1;
-  if (strcmp (&prev_word->word[dot_loc], ".") == SAME)
+  FILE *fp = fopen (path, "r");
+  if (fp == NULL)
     {
-      return 0;
+      return NULL;
     }
-  return 1;
+  double start = get_time ();
+  Dictionary *dictionary = new_dictionary (order);
+  fill_dictionary (fp, words_to_read, dictionary, threads);
+  fclose(fp);
+  stats->phases[PHASE_INGEST] += get_time () - start;
+  stats->tokens += count_tokens (dictionary);
+  measure_dictionary (dictionary, stats->dictionary_bytes);
+  start = get_time ();
+  dictionary = apply_pruning (dictionary, pruning);
+  stats->phases[PHASE_PRUNE] += get_time () - start;
+  start = get_time ();
+  Model *model = freeze_dictionary (dictionary);
+  free_dictionary (dictionary);
+  stats->phases[PHASE_FREEZE] += get_time () - start;
+  return model;
 }
 
 /**
- * handles the memory allocation for the program
- * @param word the WordStruct to allocate memory for
- * @param word_or_prob_list a flag determining the memory type
- * @return a pointer to the WordStruct
+ * Counts the words and bigrams of the corpus file, without building a model,
+ * and writes the most frequent of them.
+ * @param path path to the corpus file
+ * @param words_to_read number of words to read, -1 for the entire file
+ * @param threads number of threads to read the file with
+ * @param top number of words and of bigrams to write
+ * @param out the buffer to write to
+ * @param bench 1 to report the counting throughput to stderr, 0 otherwise
+ * @return 0 on success, 1 if the file can't be opened
  */
-WordStruct *memory_allocation (WordStruct *word, int word_or_prob_list)
+int count_corpus (const char *path, int words_to_read, int threads,
+                  uint32_t top, OutputBuffer *out, int bench)
 {
-  if (word_or_prob_list == 0)
-    {
-      WordStruct *temp_word = (WordStruct *) calloc (1,
-                                                     sizeof (WordStruct));
-      if (temp_word == NULL)
-        {
-          printf(ALOCATION_FAILURE);
-          exit (EXIT_FAILURE);
-        }
-      temp_word->word = (char *) calloc (1, MAX_WORD_LENGTH);
-      if (temp_word->word == NULL)
-        {
-          printf(ALOCATION_FAILURE);
-          exit (EXIT_FAILURE);
-        }
-      return temp_word;
-    }
-  if (word_or_prob_list == 1)
+  FILE *fp = fopen (path, "r");
+  if (fp == NULL)
     {
-      word->prob_list = (WordProbability *) calloc (1,
-                                                    sizeof (WordProbability));
-      if (word->prob_list == NULL)
-        {
-          printf(ALOCATION_FAILURE);
-          exit (EXIT_FAILURE);
-        }
+      return 1;
     }
-  if (word_or_prob_list == 2)
+  struct stat file_stat;
+  double megabytes = fstat (fileno (fp), &file_stat) == 0
+                     ? (double) file_stat.st_size / MEGABYTE : 0;
+  double start = get_time ();
+  Dictionary *dictionary = new_dictionary (MIN_ORDER);
+  dictionary->count_only = 1;
+  fill_dictionary (fp, words_to_read, dictionary, threads);
+  fclose(fp);
+  double elapsed = get_time () - start;
+  if (bench == 1)
     {
-      word->prob_list = (WordProbability *) realloc (word->prob_list,
-                                                     (word->prob_list_size + 1)
-                                                     * sizeof (WordProbability));
-      if (word->prob_list == NULL)
-        {
-          printf(ALOCATION_FAILURE);
-          exit (EXIT_FAILURE);
-        }
+      uint64_t tokens = count_tokens (dictionary);
+      fprintf (stderr, COUNT_REPORT, (unsigned long long) tokens, elapsed,
+               rate_of (tokens, elapsed),
+               elapsed > 0 ? megabytes / elapsed : 0);
     }
+  write_top (dictionary, top, out);
+  free_dictionary (dictionary);
   return 0;
 }
 
 /**
- * loads the word to the dictionary and copies the word to the WordStruct
- * @param dictionary the dictionary
- * @param temp_word the WordStruct
- * @param word the word
- * @param new_word a flag telling the function if to add to the dictionary or
- * not
+ * Adds a corpus file to a model, like the end of the corpus the model was
+ * built from, without thawing the model: the file is read into a
+ * dictionary of its own, which is mapped onto the model, and only the rows
+ * the file adds successors to are thawed and frozen again. The rest of the
+ * model is copied as is, so the cost is a copy of the model and the work of
+ * the new data. The old corpus is never read again.
+ * @param model the model to add to, left as is
+ * @param path path to the corpus file to add
+ * @param threads number of threads to read the file with
+ * @param bench 1 to report the update to stderr, 0 otherwise
+ * @param stats the stats the phases are added to
+ * @return the updated model, NULL if the file can't be opened
  */
-void
-load_word (LinkList *dictionary, WordStruct *temp_word, char *word,
-           int new_word)
+Model *append_model (const Model *model, const char *path, int threads,
+                     int bench, Stats *stats)
 {
-  strcpy (temp_word->word, word);
-  temp_word->number_of_occurrence += 1;
-  if (new_word == 1)
+  FILE *fp = fopen (path, "r");
+  if (fp == NULL)
     {
-      add (dictionary, temp_word);
+      return NULL;
     }
-}
-
-/**
- * checks if the word already exists in the dictionary
- * @param dictionary the dictionary
- * @param word the word being checks
- * @return a pointer to the relevant WordStruct else NULL
- */
-WordStruct *check_word (LinkList *dictionary, char *word)
-{
-  Node *temp = dictionary->first;
-  while (temp != NULL)
+  double start = get_time ();
+  Update update;
+  memset (&update, 0, sizeof (Update));
+  update.delta = new_dictionary ((int) model->header->order);
+  fill_dictionary (fp, -1, update.delta, threads);
+  fclose(fp);
+  double phase_start = get_time ();
+  stats->phases[PHASE_INGEST] += phase_start - start;
+  stats->tokens += count_tokens (update.delta);
+  measure_dictionary (update.delta, stats->dictionary_bytes);
+  map_words (model, &update);
+  map_contexts (model, &update);
+  merge_rows (model, &update);
+  stats->phases[PHASE_THAW] += get_time () - phase_start;
+  phase_start = get_time ();
+  Model *updated = freeze_update (model, &update);
+  stats->phases[PHASE_FREEZE] += get_time () - phase_start;
+  if (bench == 1)
     {
-      if (strcmp (temp->data->word, word) == SAME)
-        {
-          return temp->data;
-        }
-      temp = temp->next;
+      fprintf (stderr, UPDATE_REPORT, (int) update.added_words,
+               (int) update.dirty_size,
+               (int) (updated->header->word_count
+                      + updated->header->context_count), get_time () - start);
     }
-  return NULL;
+  free_update (&update);
+  return updated;
 }
 
 /**
- * Free the given dictionary and all of it's content from memory.
- * @param dictionary Dictionary to free
+ * Adds a corpus file to a model and prunes the result, or only prunes the
+ * model. Pruning changes the ids, so the model is thawed back to a
+ * dictionary, the file is read into it like the end of the corpus the model
+ * was built from, and every row is frozen again. Without pruning, the file
+ * is appended by append_model.
+ * @param model the model to add to, left as is
+ * @param path path to the corpus file to add, NULL to only prune the model
+ * @param threads number of threads to read the file with
+ * @param pruning the words and successors to keep
+ * @param bench 1 to report the update to stderr, 0 otherwise
+ * @param stats the stats the phases are added to
+ * @return the updated model, NULL if the file can't be opened
  */
-void free_dictionary (LinkList *dictionary)
+Model *update_model (const Model *model, const char *path, int threads,
+                     const Pruning *pruning, int bench, Stats *stats)
 {
-  Node *temp = dictionary->first;
-  Node *temp2 = NULL;
-  while (temp != NULL)
-    {
-      free (temp->data->prob_list);
-      free (temp->data->word);
-      free (temp->data);
-      temp2 = temp;
-      temp = temp->next;
-      free (temp2);
-    }
-  free (dictionary);
-}
-
-int check_input (int size)
-{
-  if (size != CORRECT_NUM_4 && size != CORRECT_NUM_5)
+  if (path != NULL && pruning->min_count <= 1 && pruning->max_words == 0)
     {
-      printf (USAGE_ERROR);
-      return EXIT_FAILURE;
+      return append_model (model, path, threads, bench, stats);
     }
-  if (size == CORRECT_NUM_5)
+  double start = get_time ();
+  Dictionary *dictionary = thaw_model (model);
+  double phase_start = get_time ();
+  stats->phases[PHASE_THAW] += phase_start - start;
+  if (path != NULL)
     {
-      return CORRECT_NUM_5;
+      FILE *fp = fopen (path, "r");
+      if (fp == NULL)
+        {
+          free_dictionary (dictionary);
+          return NULL;
+        }
+      uint64_t tokens = count_tokens (dictionary);
+      fill_dictionary (fp, -1, dictionary, threads);
+      fclose(fp);
+      stats->tokens += count_tokens (dictionary) - tokens;
+      stats->phases[PHASE_INGEST] += get_time () - phase_start;
     }
-  else
+  measure_dictionary (dictionary, stats->dictionary_bytes);
+  int added = dictionary->size - (int) model->header->word_count;
+  phase_start = get_time ();
+  dictionary = apply_pruning (dictionary, pruning);
+  stats->phases[PHASE_PRUNE] += get_time () - phase_start;
+  phase_start = get_time ();
+  Model *updated = freeze_dictionary (dictionary);
+  stats->phases[PHASE_FREEZE] += get_time () - phase_start;
+  if (bench == 1)
     {
-      return CORRECT_NUM_4;
+      int rows = dictionary->size + (int) dictionary->contexts.size;
+      fprintf (stderr, UPDATE_REPORT, added, rows, rows, get_time () - start);
     }
+  free_dictionary (dictionary);
+  return updated;
 }
 
 /**
@@ -446,52 +695,178 @@ int check_input (int size)
  *             2) Number of sentences to generate
  *             3) Path to file
  *             4) Optional - Number of words to read
+ *             Optional flags, anywhere:
+ *             --bench to report tweets/sec to stderr
+ *             --threads <n> to read the file and generate the tweets with
+ *             n threads
+ *             --order <n> to condition every word on up to n - 1 words
+ *             before it, for n in [2, 4] (2 by default)
+ *             --save-model <path> to write the model built from the file
+ *             --load-model <path> to generate from a saved model, in which
+ *             case the path to file and number of words aren't given
+ *             --output <path> to write the tweets to a file, not stdout
+ *             --append <path> to add another corpus file to the model, built
+ *             or loaded, before it is saved and used
+ *             --min-count <n> to drop the words and successors seen fewer
+ *             than n times
+ *             --max-words <n> to keep only the n most frequent words
+ *             --serve <path> to answer requests for tweets on a Unix domain
+ *             socket with a pool of --threads threads, in which case the
+ *             seed and number of sentences aren't given
+ *             --stats <text|json> to report the time of every phase, the
+ *             size of the model and of the structures behind it, and the
+ *             throughputs to stderr
+ *             --max-chars <n> to generate only tweets of at most n
+ *             characters, after "Tweet i: ", that end with a word that
+ *             ends with a dot
+ *             --count <k> to only count the words of the file and write the
+ *             k most frequent words and bigrams, in which case the seed and
+ *             number of sentences aren't given
  */
 int main (int argc, char *argv[])
 {
-  int check_inputs = check_input(argc);
-  if (check_inputs != CORRECT_NUM_4 && check_inputs != CORRECT_NUM_5)
+  Options options;
+  if (parse_options (argc, argv, &options) != 0)
     {
+      printf (USAGE_ERROR);
       return EXIT_FAILURE;
-
     }
-  char *ptr = NULL;
-  int seed = strtol (argv[1], &ptr, BASE);
-  int num_of_tweets = strtol (argv[2], &ptr, BASE);
-  FILE *fp = fopen (argv[3], "r");
-  if (fp == NULL)
+  Arguments arguments;
+  if (parse_arguments (&options, &arguments) != 0)
     {
-      printf (FILE_ERROR);
       return EXIT_FAILURE;
     }
-  if (check_inputs == CORRECT_NUM_4)
+  if (options.count > 0)
     {
-      LinkList *dictionary = (LinkList *) calloc (1,sizeof (LinkList));
-      if (dictionary == NULL)
+      OutputBuffer out;
+      if (open_output (&out, options.output) != 0)
         {
+          printf (OUTPUT_ERROR);
+          return EXIT_FAILURE;
+        }
+      if (count_corpus (arguments.corpus, arguments.words_to_read,
+                        options.threads, options.count, &out,
+                        options.bench) != 0)
+        {
+          printf (FILE_ERROR);
+          close_output (&out);
+          return EXIT_FAILURE;
+        }
+      if (close_output (&out) != 0)
+        {
+          printf (OUTPUT_ERROR);
           return EXIT_FAILURE;
         }
-      fill_dictionary (fp, -1, dictionary);
-      fclose(fp);
-      srand (seed);
-      create_tweets (num_of_tweets, dictionary);
-      free_dictionary (dictionary);
       return 0;
     }
-  if (check_inputs == CORRECT_NUM_5)
+  Stats stats;
+  memset (&stats, 0, sizeof (Stats));
+  Model *model = NULL;
+  if (options.load_model != NULL)
     {
-      LinkList *dictionary = (LinkList *) calloc (1, sizeof (LinkList));
-      if (dictionary == NULL)
+      double start = get_time ();
+      model = load_model (options.load_model);
+      if (model == NULL)
         {
+          printf (MODEL_ERROR);
+          return EXIT_FAILURE;
+        }
+      stats.phases[PHASE_LOAD] = get_time () - start;
+    }
+  else
+    {
+      // when a file is appended, the pruning waits for its counts too
+      Pruning keep_all = {1, 0};
+      model = build_model (arguments.corpus, arguments.words_to_read,
+                           options.threads, options.order,
+                           options.append == NULL ? &options.pruning
+                                                  : &keep_all, &stats);
+      if (model == NULL)
+        {
+          printf (FILE_ERROR);
+          return EXIT_FAILURE;
+        }
+    }
+  if (options.append != NULL
+      || (options.load_model != NULL && (options.pruning.min_count > 1
+                                         || options.pruning.max_words > 0)))
+    {
+      Model *updated = update_model (model, options.append, options.threads,
+                                     &options.pruning, options.bench,
+                                     &stats);
+      free_model (model);
+      if (updated == NULL)
+        {
+          printf (FILE_ERROR);
+          return EXIT_FAILURE;
+        }
+      model = updated;
+    }
+  double start = get_time ();
+  if (options.save_model != NULL && save_model (model, options.save_model) != 0)
+    {
+      printf (SAVE_ERROR);
+      free_model (model);
+      return EXIT_FAILURE;
+    }
+  stats.phases[PHASE_SAVE] = get_time () - start;
+  if (options.bench == 1)
+    {
+      report_model (model);
+    }
+  Constraint *constraint = NULL;
+  if (options.max_chars > 0)
+    {
+      constraint = build_constraint (model, options.max_chars);
+    }
+  if (options.serve != NULL)
+    {
+      if (options.stats != STATS_NONE)
+        {
+          report_stats (&stats, model, options.stats);
+        }
+      if (serve (model, constraint, options.serve, options.threads) != 0)
+        {
+          printf (SERVE_ERROR);
+          free_constraint (constraint);
+          free_model (model);
           return EXIT_FAILURE;
         }
-      int words_to_read = strtol (argv[4], &ptr, BASE);
-      fill_dictionary (fp, words_to_read, dictionary);
-      fclose(fp);
-      srand (seed);
-      create_tweets (num_of_tweets, dictionary);
-      free_dictionary (dictionary);
       return 0;
     }
-  return EXIT_FAILURE;
-}
\ No newline at end of file
+  int seed = arguments.seed;
+  int num_of_tweets = arguments.num_of_tweets;
+  OutputBuffer out;
+  if (open_output (&out, options.output) != 0)
+    {
+      printf (OUTPUT_ERROR);
+      free_constraint (constraint);
+      free_model (model);
+      return EXIT_FAILURE;
+    }
+  stats.phases[PHASE_GENERATE] = run_generation (num_of_tweets, seed, model,
+                                                 constraint, options.threads,
+                                                 &out, options.bench);
+  stats.tweets = num_of_tweets;
+  if (options.stats != STATS_NONE)
+    {
+      report_stats (&stats, model, options.stats);
+    }
+  if (options.bench == 1)
+    {
+      uint64_t draws = (uint64_t) num_of_tweets
+                       * MAX_WORDS_IN_SENTENCE_GENERATION;
+      bench_sampling (model, seed, draws, get_next_cumulative_word,
+                      "a binary search");
+      bench_sampling (model, seed, draws, get_next_random_word,
+                      "alias tables");
+    }
+  free_constraint (constraint);
+  free_model (model);
+  if (close_output (&out) != 0)
+    {
+      printf (OUTPUT_ERROR);
+      return EXIT_FAILURE;
+    }
+  return 0;
+}
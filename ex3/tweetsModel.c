@@ -0,0 +1,613 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "tweetsModel.h"
+#include "tweetsCommon.h"
+
+#define MODEL_MAGIC "TWTMODEL"
+#define MODEL_VERSION 4
+#define MODEL_ALIGNMENT 8
+
+/**
+ * Computes where every section of a model with the header's counts starts,
+ * and the size of the whole model.
+ * @param header a header with its counts set, whose offsets are filled
+ */
+void plan_model (ModelHeader *header)
+{
+  uint64_t sizes[SECTION_COUNT];
+  sizes[SECTION_TEXT] = header->text_size;
+  sizes[SECTION_TEXT_OFFSETS] = ((uint64_t) header->word_count + 1)
+                                * sizeof (uint64_t);
+  sizes[SECTION_OCCURRENCES] = header->word_count * sizeof (uint32_t);
+  sizes[SECTION_STARTERS] = header->starter_count * sizeof (uint32_t);
+  sizes[SECTION_ROWS] = ((uint64_t) header->word_count
+                         + header->context_count + 1) * sizeof (uint64_t);
+  sizes[SECTION_SUCCESSORS] = header->edge_count * sizeof (uint32_t);
+  sizes[SECTION_CUMULATIVE] = header->edge_count * sizeof (uint32_t);
+  sizes[SECTION_ALIAS] = header->edge_count * sizeof (AliasEntry);
+  sizes[SECTION_CONTEXT_KEYS] = header->context_slots * sizeof (uint64_t);
+  sizes[SECTION_CONTEXT_INDICES] = header->context_slots * sizeof (uint32_t);
+  uint64_t offset = sizeof (ModelHeader);
+  for (int i = 0; i < SECTION_COUNT; ++i)
+    {
+      offset = (offset + MODEL_ALIGNMENT - 1) & ~(uint64_t) (MODEL_ALIGNMENT
+                                                              - 1);
+      header->sections[i] = offset;
+      offset += sizes[i];
+    }
+  header->size = offset;
+}
+
+int check_model (const Model *model);
+
+/**
+ * Points the model's fields at the sections of the buffer its header
+ * starts.
+ * @param model the model
+ * @param buffer the model buffer
+ * @param check 1 to check the whole model, for a buffer that comes from a
+ * file, 0 for one that was just frozen
+ * @return 0 on success, 1 if the model was checked and is invalid
+ */
+int view_model (Model *model, void *buffer, int check)
+{
+  char *base = (char *) buffer;
+  model->header = (ModelHeader *) buffer;
+  uint64_t *sections = model->header->sections;
+  model->text = base + sections[SECTION_TEXT];
+  model->text_offsets = (uint64_t *) (base + sections[SECTION_TEXT_OFFSETS]);
+  model->occurrences = (uint32_t *) (base + sections[SECTION_OCCURRENCES]);
+  model->starters = (uint32_t *) (base + sections[SECTION_STARTERS]);
+  model->rows = (uint64_t *) (base + sections[SECTION_ROWS]);
+  model->successors = (uint32_t *) (base + sections[SECTION_SUCCESSORS]);
+  model->cumulative = (uint32_t *) (base + sections[SECTION_CUMULATIVE]);
+  model->alias = (AliasEntry *) (base + sections[SECTION_ALIAS]);
+  model->context_keys = (uint64_t *) (base + sections[SECTION_CONTEXT_KEYS]);
+  model->context_indices = (uint32_t *) (base
+                                         + sections[SECTION_CONTEXT_INDICES]);
+  return check == 1 ? check_model (model) : 0;
+}
+
+/**
+ * places a context in the model's context table, which has a free slot
+ * @param model the model
+ * @param key the key of the context
+ * @param index the index of the context
+ */
+void insert_context (Model *model, uint64_t key, uint32_t index)
+{
+  uint64_t *keys = (uint64_t *) model->context_keys;
+  uint32_t mask = model->header->context_slots - 1;
+  uint32_t slot = (uint32_t) hash_key (key) & mask;
+  while (keys[slot] != EMPTY_KEY)
+    {
+      slot = (slot + 1) & mask;
+    }
+  keys[slot] = key;
+  ((uint32_t *) model->context_indices)[slot] = index;
+}
+
+/**
+ * checks the words of a model: every word has at least one character and a
+ * '\0' inside the text, no two words are the same, and every starter is a
+ * word
+ * @param model the model
+ * @return 0 if the words are valid, 1 otherwise
+ */
+int check_words (const Model *model)
+{
+  const ModelHeader *header = model->header;
+  if (model->text_offsets[0] != 0)
+    {
+      return 1;
+    }
+  for (uint32_t id = 0; id < header->word_count; ++id)
+    {
+      uint64_t end = model->text_offsets[id + 1];
+      // ends_with_dot reads the character before the '\0'
+      if (end > header->text_size || end < model->text_offsets[id] + 2
+          || model->text[end - 1] != '\0')
+        {
+          return 1;
+        }
+    }
+  for (uint32_t i = 0; i < header->starter_count; ++i)
+    {
+      if (model->starters[i] >= header->word_count)
+        {
+          return 1;
+        }
+    }
+  // thawing interns the words by their text, which must give every word
+  // its own id back
+  uint32_t capacity = WORDS_INITIAL_CAP;
+  while (capacity < 2 * (uint64_t) header->word_count)
+    {
+      capacity *= 2;
+    }
+  uint32_t *slots = (uint32_t *) calloc (capacity, sizeof (uint32_t));
+  if (slots == NULL)
+    {
+      printf(ALOCATION_FAILURE);
+      exit (EXIT_FAILURE);
+    }
+  int result = 0;
+  for (uint32_t id = 0; id < header->word_count && result == 0; ++id)
+    {
+      const char *word = model->text + model->text_offsets[id];
+      uint64_t length = model->text_offsets[id + 1] - model->text_offsets[id];
+      uint32_t slot = hash_word (word, (int) length - 1) & (capacity - 1);
+      while (slots[slot] != 0 && result == 0)
+        {
+          uint32_t other = slots[slot] - 1;
+          result = model->text_offsets[other + 1] - model->text_offsets[other]
+                   == length && memcmp (model->text
+                                        + model->text_offsets[other], word,
+                                        length) == SAME;
+          slot = (slot + 1) & (capacity - 1);
+        }
+      slots[slot] = id + 1;
+    }
+  free (slots);
+  return result;
+}
+
+/**
+ * checks the successor rows of a model: the row offsets grow up to the
+ * number of successors, every successor and alias is a word, and every
+ * successor was counted at least once, so the running sums grow
+ * @param model the model
+ * @return 0 if the rows are valid, 1 otherwise
+ */
+int check_rows (const Model *model)
+{
+  const ModelHeader *header = model->header;
+  uint32_t words = header->word_count;
+  uint32_t nodes = words + header->context_count;
+  if (model->rows[0] != 0 || model->rows[nodes] != header->edge_count)
+    {
+      return 1;
+    }
+  for (uint32_t node = 0; node < nodes; ++node)
+    {
+      uint64_t low = model->rows[node];
+      uint64_t high = model->rows[node + 1];
+      // the length of a row is drawn from as a 32 bit number
+      if (high < low || high > header->edge_count || high - low > UINT32_MAX)
+        {
+          return 1;
+        }
+      for (uint64_t e = low; e < high; ++e)
+        {
+          if (model->successors[e] >= words
+              || model->alias[e].successor >= words
+              || model->alias[e].alias >= words
+              || model->cumulative[e] <= (e == low ? 0
+                                                   : model->cumulative[e - 1]))
+            {
+              return 1;
+            }
+        }
+    }
+  return 0;
+}
+
+/**
+ * checks the context table of a model: it has a free slot to end the
+ * probing, every key is made of a word or a context and a word, and every
+ * context is found, in exactly one slot
+ * @param model the model
+ * @return 0 if the table is valid, 1 otherwise
+ */
+int check_contexts (const Model *model)
+{
+  const ModelHeader *header = model->header;
+  uint32_t words = header->word_count;
+  uint32_t contexts = header->context_count;
+  uint32_t slots = header->context_slots;
+  if ((slots & (slots - 1)) != 0 || (slots == 0 && contexts > 0)
+      || (slots > 0 && contexts >= slots))
+    {
+      return 1;
+    }
+  unsigned char *seen = (unsigned char *) calloc ((size_t) contexts + 1, 1);
+  if (seen == NULL)
+    {
+      printf(ALOCATION_FAILURE);
+      exit (EXIT_FAILURE);
+    }
+  uint32_t used = 0;
+  int result = 0;
+  for (uint32_t slot = 0; slot < slots && result == 0; ++slot)
+    {
+      uint64_t key = model->context_keys[slot];
+      if (key == EMPTY_KEY)
+        {
+          continue;
+        }
+      uint32_t node = key >> 32;
+      uint32_t index = model->context_indices[slot];
+      result = ((node & CONTEXT_BIT) ? (node & ~CONTEXT_BIT) >= contexts
+                                     : node >= words)
+               || (uint32_t) key >= words || index >= contexts
+               || seen[index] == 1 || find_context_index (model, key) != index;
+      if (result == 0)
+        {
+          seen[index] = 1;
+          used++;
+        }
+    }
+  free (seen);
+  return result == 1 || used != contexts;
+}
+
+/**
+ * checks that every offset and id of the model stays inside it, so a model
+ * file can't make generating or thawing read out of its buffer. This takes
+ * a pass over the whole model.
+ * @param model the model, viewed over a buffer of the size its header
+ * plans
+ * @return 0 if the model is valid, 1 otherwise
+ */
+int check_model (const Model *model)
+{
+  const ModelHeader *header = model->header;
+  // the ids of the nodes and the contexts' keys leave CONTEXT_BIT free
+  if (header->order < MIN_ORDER || header->order > MAX_ORDER
+      || (uint64_t) header->word_count + header->context_count >= CONTEXT_BIT)
+    {
+      return 1;
+    }
+  return check_words (model) == 1 || check_rows (model) == 1
+         || check_contexts (model) == 1;
+}
+
+/**
+ * Stores the contexts of the dictionary in the model's context table.
+ * @param model the model, with its header filled
+ * @param dictionary the dictionary
+ */
+void freeze_contexts (Model *model, const Dictionary *dictionary)
+{
+  for (uint32_t i = 0; i < model->header->context_slots; ++i)
+    {
+      ((uint64_t *) model->context_keys)[i] = EMPTY_KEY;
+    }
+  for (uint32_t i = 0; i < dictionary->contexts.size; ++i)
+    {
+      insert_context (model, dictionary->contexts.keys[i], i);
+    }
+}
+
+/**
+ * Stores the successors of the dictionary's contexts in the model, after
+ * the rows of the words. The ngrams are grouped by context with a counting
+ * sort, which keeps every context's successors in the order they were
+ * first seen.
+ * @param model the model, with the rows of the words filled
+ * @param dictionary the dictionary
+ * @param edge index of the first successor of the contexts
+ */
+void freeze_ngrams (Model *model, const Dictionary *dictionary, uint64_t edge)
+{
+  uint64_t *rows = (uint64_t *) model->rows + dictionary->size;
+  uint32_t *successors = (uint32_t *) model->successors;
+  uint32_t *cumulative = (uint32_t *) model->cumulative;
+  uint32_t contexts = dictionary->contexts.size;
+  for (uint32_t i = 0; i <= contexts; ++i)
+    {
+      rows[i] = 0;
+    }
+  for (uint32_t i = 0; i < dictionary->ngrams.size; ++i)
+    {
+      rows[((dictionary->ngrams.keys[i] >> 32) & ~CONTEXT_BIT) + 1]++;
+    }
+  rows[0] = edge;
+  for (uint32_t i = 1; i <= contexts; ++i)
+    {
+      rows[i] += rows[i - 1];
+    }
+  // rows[i] is used as the next free edge of context i while placing, which
+  // leaves it at the start of context i + 1; shifting back restores it
+  for (uint32_t i = 0; i < dictionary->ngrams.size; ++i)
+    {
+      uint32_t context = (dictionary->ngrams.keys[i] >> 32) & ~CONTEXT_BIT;
+      uint64_t place = rows[context]++;
+      successors[place] = (uint32_t) dictionary->ngrams.keys[i];
+      cumulative[place] = dictionary->ngrams.counts[i];
+    }
+  for (uint32_t i = contexts; i > 0; --i)
+    {
+      rows[i] = rows[i - 1];
+    }
+  rows[0] = edge;
+  for (uint32_t i = 0; i < contexts; ++i)
+    {
+      for (uint64_t place = rows[i] + 1; place < rows[i + 1]; ++place)
+        {
+          cumulative[place] += cumulative[place - 1];
+        }
+    }
+}
+
+/**
+ * Builds the alias table of a successor row with Vose's method, in integer
+ * arithmetic so it is exact: every column starts with the occurrences of
+ * its successor times the length of the row, which makes the average
+ * column the total of the row. Columns below the total are filled up by
+ * columns above it until every column holds exactly the total.
+ * @param model the model, with the row's successors and running sums
+ * @param start index of the first successor of the row
+ * @param length number of successors in the row
+ * @param weights, small, large scratch arrays of at least length entries
+ */
+void build_alias_row (Model *model, uint64_t start, uint32_t length,
+                      uint64_t *weights, uint32_t *small, uint32_t *large)
+{
+  AliasEntry *alias = (AliasEntry *) model->alias + start;
+  const uint32_t *cumulative = model->cumulative + start;
+  uint64_t total = cumulative[length - 1];
+  uint32_t small_size = 0;
+  uint32_t large_size = 0;
+  for (uint32_t i = 0; i < length; ++i)
+    {
+      weights[i] = (uint64_t) (cumulative[i]
+                               - (i == 0 ? 0 : cumulative[i - 1])) * length;
+      alias[i].successor = model->successors[start + i];
+      if (weights[i] < total)
+        {
+          small[small_size++] = i;
+        }
+      else
+        {
+          large[large_size++] = i;
+        }
+    }
+  while (small_size > 0 && large_size > 0)
+    {
+      uint32_t column = small[--small_size];
+      uint32_t donor = large[large_size - 1];
+      alias[column].threshold = (uint32_t) weights[column];
+      alias[column].alias = alias[donor].successor;
+      weights[donor] -= total - weights[column];
+      if (weights[donor] < total)
+        {
+          large_size--;
+          small[small_size++] = donor;
+        }
+    }
+  // whatever is left holds exactly the total
+  while (large_size > 0)
+    {
+      uint32_t column = large[--large_size];
+      alias[column].threshold = (uint32_t) total;
+      alias[column].alias = alias[column].successor;
+    }
+  while (small_size > 0)
+    {
+      uint32_t column = small[--small_size];
+      alias[column].threshold = (uint32_t) total;
+      alias[column].alias = alias[column].successor;
+    }
+}
+
+/**
+ * Builds the alias tables of all the rows of the model.
+ * @param model the model, with all its rows filled
+ */
+void freeze_alias (Model *model)
+{
+  uint32_t nodes = model->header->word_count + model->header->context_count;
+  uint64_t longest = 0;
+  for (uint32_t node = 0; node < nodes; ++node)
+    {
+      uint64_t length = model->rows[node + 1] - model->rows[node];
+      longest = length > longest ? length : longest;
+    }
+  uint64_t *weights = (uint64_t *) malloc ((longest + 1) * sizeof (uint64_t));
+  uint32_t *small = (uint32_t *) malloc ((longest + 1) * sizeof (uint32_t));
+  uint32_t *large = (uint32_t *) malloc ((longest + 1) * sizeof (uint32_t));
+  if (weights == NULL || small == NULL || large == NULL)
+    {
+      printf(ALOCATION_FAILURE);
+      exit (EXIT_FAILURE);
+    }
+  for (uint32_t node = 0; node < nodes; ++node)
+    {
+      uint64_t start = model->rows[node];
+      uint32_t length = (uint32_t) (model->rows[node + 1] - start);
+      if (length == 0)
+        {
+          continue;
+        }
+      build_alias_row (model, start, length, weights, small, large);
+    }
+  free (weights);
+  free (small);
+  free (large);
+}
+
+/**
+ * Stores the successors of a word's prob_list, or of a row being updated,
+ * in the model with their running sums.
+ * @param model the model
+ * @param word the successors
+ * @param edge index of the row's first successor in the model
+ * @return index of the successor after the row
+ */
+uint64_t freeze_row (Model *model, const WordStruct *word, uint64_t edge)
+{
+  uint32_t sum = 0;
+  for (int i = 0; i < word->prob_list_size; ++i, ++edge)
+    {
+      sum += word->prob_list[i].num_of_occurrnces;
+      ((uint32_t *) model->successors)[edge] = word->prob_list[i].word_id;
+      ((uint32_t *) model->cumulative)[edge] = sum;
+    }
+  return edge;
+}
+
+/**
+ * Builds the model of the filled dictionary. Every row of successors is
+ * stored with the running sums of its occurrences, and with the alias table
+ * that sampling the next word uses. The rows of the contexts follow the
+ * rows of the words.
+ * @param dictionary the filled dictionary
+ * @return the model, on the heap
+ */
+Model *freeze_dictionary (Dictionary *dictionary)
+{
+  ModelHeader header = {0};
+  memcpy (header.magic, MODEL_MAGIC, MODEL_MAGIC_SIZE);
+  header.version = MODEL_VERSION;
+  header.word_count = dictionary->size;
+  header.starter_count = dictionary->starters_size;
+  header.order = dictionary->order;
+  header.context_count = dictionary->contexts.size;
+  while (header.context_slots < 2 * header.context_count)
+    {
+      header.context_slots = header.context_slots == 0
+                             ? NGRAM_INITIAL_CAP : header.context_slots * 2;
+    }
+  header.edge_count = dictionary->ngrams.size;
+  for (int id = 0; id < dictionary->size; ++id)
+    {
+      header.edge_count += dictionary->words[id].prob_list_size;
+      header.text_size += dictionary->words[id].length + 1;
+    }
+  plan_model (&header);
+  Model *model = (Model *) calloc (1, sizeof (Model));
+  void *buffer = calloc (1, header.size);
+  if (model == NULL || buffer == NULL)
+    {
+      printf(ALOCATION_FAILURE);
+      exit (EXIT_FAILURE);
+    }
+  memcpy (buffer, &header, sizeof (ModelHeader));
+  view_model (model, buffer, 0);
+  char *text = (char *) model->text;
+  uint64_t *text_offsets = (uint64_t *) model->text_offsets;
+  uint32_t *occurrences = (uint32_t *) model->occurrences;
+  uint64_t *rows = (uint64_t *) model->rows;
+  uint64_t text_size = 0;
+  uint64_t edge = 0;
+  for (int id = 0; id < dictionary->size; ++id)
+    {
+      WordStruct *word = &dictionary->words[id];
+      text_offsets[id] = text_size;
+      memcpy (text + text_size, word->word, word->length + 1);
+      text_size += word->length + 1;
+      occurrences[id] = word->number_of_occurrence;
+      rows[id] = edge;
+      edge = freeze_row (model, word, edge);
+    }
+  text_offsets[dictionary->size] = text_size;
+  for (int i = 0; i < dictionary->starters_size; ++i)
+    {
+      ((uint32_t *) model->starters)[i] = dictionary->starters[i];
+    }
+  freeze_ngrams (model, dictionary, edge);
+  freeze_contexts (model, dictionary);
+  freeze_alias (model);
+  return model;
+}
+
+/**
+ * Writes the model to the given file.
+ * @param model the model
+ * @param path path of the file to write
+ * @return 0 on success, 1 otherwise
+ */
+int save_model (const Model *model, const char *path)
+{
+  FILE *fp = fopen (path, "wb");
+  if (fp == NULL)
+    {
+      return 1;
+    }
+  size_t written = fwrite (model->header, 1, model->header->size, fp);
+  if (fclose (fp) != 0 || written != model->header->size)
+    {
+      return 1;
+    }
+  return 0;
+}
+
+/**
+ * Maps the model file to memory, and checks it with one pass over the
+ * whole model, so a corrupt or hostile file is rejected instead of read
+ * out of bounds later.
+ * @param path path of the model file
+ * @return the model, NULL if the file can't be mapped or isn't a model
+ */
+Model *load_model (const char *path)
+{
+  FILE *fp = fopen (path, "rb");
+  if (fp == NULL)
+    {
+      return NULL;
+    }
+  struct stat file_stat;
+  void *buffer = MAP_FAILED;
+  if (fstat (fileno (fp), &file_stat) == 0
+      && (size_t) file_stat.st_size >= sizeof (ModelHeader))
+    {
+      buffer = mmap (NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE,
+                     fileno (fp), 0);
+    }
+  fclose (fp);
+  if (buffer == MAP_FAILED)
+    {
+      return NULL;
+    }
+  ModelHeader expected = *(ModelHeader *) buffer;
+  plan_model (&expected);
+  if (memcmp (expected.magic, MODEL_MAGIC, MODEL_MAGIC_SIZE) != SAME
+      || expected.version != MODEL_VERSION
+      || memcmp (&expected, buffer, sizeof (ModelHeader)) != SAME
+      || expected.size != (uint64_t) file_stat.st_size
+      // bounding the sizes keeps the planned offsets from wrapping around
+      || expected.text_size > expected.size
+      || expected.edge_count > expected.size)
+    {
+      munmap (buffer, file_stat.st_size);
+      return NULL;
+    }
+  Model *model = (Model *) calloc (1, sizeof (Model));
+  if (model == NULL)
+    {
+      munmap (buffer, file_stat.st_size);
+      return NULL;
+    }
+  if (view_model (model, buffer, 1) != 0)
+    {
+      munmap (buffer, file_stat.st_size);
+      free (model);
+      return NULL;
+    }
+  model->mapped = 1;
+  return model;
+}
+
+/**
+ * Frees the model, unmapping it if it was loaded from a file.
+ * @param model the model
+ */
+void free_model (Model *model)
+{
+  if (model->mapped == 1)
+    {
+      munmap (model->header, model->header->size);
+    }
+  else
+    {
+      free (model->header);
+    }
+  free (model);
+}
+
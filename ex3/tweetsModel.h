@@ -0,0 +1,284 @@
+#ifndef TWEETS_MODEL_H_
+#define TWEETS_MODEL_H_
+
+#include <stdint.h>
+#include "tweetsDictionary.h"
+
+/*
+ * The frozen model tweets are generated from, which is built from a
+ * dictionary, saved to a file as is and mapped back from it.
+ */
+
+#define MODEL_MAGIC_SIZE 8
+
+/**
+ * @enum Section - the arrays of a model, in the order they are laid out.
+ * SECTION_TEXT: the words, '\0' terminated, one after the other.
+ * SECTION_TEXT_OFFSETS: word_count + 1 uint64 offsets of words in the text.
+ * SECTION_OCCURRENCES: uint32 number of occurrences of every word.
+ * SECTION_STARTERS: uint32 ids of the words that don't end with a dot.
+ * SECTION_ROWS: node_count + 1 uint64 offsets of the nodes' successors.
+ * A node is a word (nodes [0, word_count)) or a context of more than one
+ * word (nodes [word_count, node_count)).
+ * SECTION_SUCCESSORS: uint32 ids of the successors of every node.
+ * SECTION_CUMULATIVE: uint32 running occurrence sums of every successor row.
+ * SECTION_ALIAS: an AliasEntry for every successor, the alias table of its
+ * row.
+ * SECTION_CONTEXT_KEYS, SECTION_CONTEXT_INDICES: context_slots uint64 keys
+ * and uint32 indices of an open addressing table, from (node of the context
+ * without its last word, last word id) to the index of the context, whose
+ * node is word_count + index. The keys are those of the dictionary's
+ * contexts, where a context is CONTEXT_BIT | its index, so they don't
+ * depend on the number of words. Unused slots have the key EMPTY_KEY.
+ */
+typedef enum Section {
+    SECTION_TEXT,
+    SECTION_TEXT_OFFSETS,
+    SECTION_OCCURRENCES,
+    SECTION_STARTERS,
+    SECTION_ROWS,
+    SECTION_SUCCESSORS,
+    SECTION_CUMULATIVE,
+    SECTION_ALIAS,
+    SECTION_CONTEXT_KEYS,
+    SECTION_CONTEXT_INDICES,
+    SECTION_COUNT
+} Section;
+
+/**
+ * @struct AliasEntry - a column of the alias table of a successor row, which
+ * draws a successor in O(1): a column is drawn uniformly, then a number in
+ * [0, total of the row). The column's own successor is taken if the number
+ * is below threshold, its alias otherwise. The thresholds are scaled by the
+ * length of the row, so the draws follow the occurrences exactly.
+ * @param successor id of the column's own successor.
+ * @param threshold the part of the column that is its own successor.
+ * @param alias id of the successor that takes the rest of the column.
+ */
+typedef struct AliasEntry {
+    uint32_t successor;
+    uint32_t threshold;
+    uint32_t alias;
+} AliasEntry;
+
+/**
+ * @struct ModelHeader - the start of a model buffer or model file.
+ * @param sections offsets of the sections from the start of the buffer.
+ * @param size the size of the whole buffer.
+ */
+typedef struct ModelHeader {
+    char magic[MODEL_MAGIC_SIZE];
+    uint32_t version;
+    uint32_t word_count;
+    uint32_t starter_count;
+    uint32_t order;
+    uint32_t context_count;
+    uint32_t context_slots;
+    uint32_t padding;
+    uint64_t edge_count;
+    uint64_t text_size;
+    uint64_t sections[SECTION_COUNT];
+    uint64_t size;
+} ModelHeader;
+
+/**
+ * @struct Model - the frozen Markov chain that tweets are generated from.
+ * The model is a single buffer holding only offsets and ids, never pointers,
+ * so it is written to a file as is and used straight from a mapping of it.
+ * The other fields point into the buffer.
+ * @param mapped 1 if the buffer is a mapping of a model file, 0 if it is on
+ * the heap.
+ */
+typedef struct Model {
+    ModelHeader *header;
+    const char *text;
+    const uint64_t *text_offsets;
+    const uint32_t *occurrences;
+    const uint32_t *starters;
+    const uint64_t *rows;
+    const uint32_t *successors;
+    const uint32_t *cumulative;
+    const AliasEntry *alias;
+    const uint64_t *context_keys;
+    const uint32_t *context_indices;
+    int mapped;
+} Model;
+
+/**
+ * Computes where every section of a model with the header's counts starts,
+ * and the size of the whole model.
+ * @param header a header with its counts set, whose offsets are filled
+ */
+void plan_model (ModelHeader *header);
+
+/**
+ * Points the model's fields at the sections of the buffer its header
+ * starts.
+ * @param model the model
+ * @param buffer the model buffer
+ * @param check 1 to check the whole model, for a buffer that comes from a
+ * file, 0 for one that was just frozen
+ * @return 0 on success, 1 if the model was checked and is invalid
+ */
+int view_model (Model *model, void *buffer, int check);
+
+/**
+ * places a context in the model's context table, which has a free slot
+ * @param model the model
+ * @param key the key of the context
+ * @param index the index of the context
+ */
+void insert_context (Model *model, uint64_t key, uint32_t index);
+
+/**
+ * Builds the alias table of a successor row with Vose's method, in integer
+ * arithmetic so it is exact: every column starts with the occurrences of
+ * its successor times the length of the row, which makes the average
+ * column the total of the row. Columns below the total are filled up by
+ * columns above it until every column holds exactly the total.
+ * @param model the model, with the row's successors and running sums
+ * @param start index of the first successor of the row
+ * @param length number of successors in the row
+ * @param weights, small, large scratch arrays of at least length entries
+ */
+void build_alias_row (Model *model, uint64_t start, uint32_t length,
+                      uint64_t *weights, uint32_t *small, uint32_t *large);
+
+/**
+ * Stores the successors of a word's prob_list, or of a row being updated,
+ * in the model with their running sums.
+ * @param model the model
+ * @param word the successors
+ * @param edge index of the row's first successor in the model
+ * @return index of the successor after the row
+ */
+uint64_t freeze_row (Model *model, const WordStruct *word, uint64_t edge);
+
+/**
+ * Builds the model of the filled dictionary. Every row of successors is
+ * stored with the running sums of its occurrences, and with the alias table
+ * that sampling the next word uses. The rows of the contexts follow the
+ * rows of the words.
+ * @param dictionary the filled dictionary
+ * @return the model, on the heap
+ */
+Model *freeze_dictionary (Dictionary *dictionary);
+
+/**
+ * Writes the model to the given file.
+ * @param model the model
+ * @param path path of the file to write
+ * @return 0 on success, 1 otherwise
+ */
+int save_model (const Model *model, const char *path);
+
+/**
+ * Maps the model file to memory, and checks it with one pass over the
+ * whole model, so a corrupt or hostile file is rejected instead of read
+ * out of bounds later.
+ * @param path path of the model file
+ * @return the model, NULL if the file can't be mapped or isn't a model
+ */
+Model *load_model (const char *path);
+
+/**
+ * Frees the model, unmapping it if it was loaded from a file.
+ * @param model the model
+ */
+void free_model (Model *model);
+
+/*
+ * The accessors below are used on every word generated, by the other parts
+ * too, so they are defined here, inline.
+ */
+
+/**
+ * @param model the model
+ * @param id id of a word
+ * @return the word, '\0' terminated
+ */
+static inline const char *word_text (const Model *model, uint32_t id)
+{
+  return model->text + model->text_offsets[id];
+}
+
+/**
+ * @param model the model
+ * @param id id of a word
+ * @return number of characters in the word
+ */
+static inline size_t word_length (const Model *model, uint32_t id)
+{
+  return model->text_offsets[id + 1] - model->text_offsets[id] - 1;
+}
+
+/**
+ * checks if there is a dot at the end of the word with the given id
+ * @param model the model
+ * @param id id of a word
+ * @return 0 if ends with a dot else 1
+ */
+static inline int ends_with_dot (const Model *model, uint32_t id)
+{
+  // the character before the word's '\0'
+  if (model->text[model->text_offsets[id + 1] - 2] == '.')
+    {
+      return 0;
+    }
+  return 1;
+}
+
+/**
+ * @param model the model
+ * @param low index of the first successor of a row
+ * @param e index of a successor of the row
+ * @return the occurrences of the successor after the row's node
+ */
+static inline uint32_t count_of (const Model *model, uint64_t low, uint64_t e)
+{
+  return model->cumulative[e] - (e == low ? 0 : model->cumulative[e - 1]);
+}
+
+/**
+ * Finds the context of the given key in the model's context table.
+ * @param model the model
+ * @param key the key of the context, as in the contexts of a dictionary
+ * @return the index of the context, -1 if the model doesn't have it
+ */
+static inline int64_t find_context_index (const Model *model, uint64_t key)
+{
+  if (model->header->context_slots == 0)
+    {
+      return -1;
+    }
+  uint32_t mask = model->header->context_slots - 1;
+  uint32_t slot = (uint32_t) hash_key (key) & mask;
+  while (model->context_keys[slot] != EMPTY_KEY)
+    {
+      if (model->context_keys[slot] == key)
+        {
+          return model->context_indices[slot];
+        }
+      slot = (slot + 1) & mask;
+    }
+  return -1;
+}
+
+/**
+ * Finds the context made of the given node followed by the given word.
+ * @param model the model
+ * @param node node of the context's words but the last
+ * @param word_id id of the context's last word
+ * @return the node of the context, -1 if the model doesn't have it
+ */
+static inline int64_t find_context (const Model *model, uint32_t node,
+                                     uint32_t word_id)
+{
+  uint32_t words = model->header->word_count;
+  int64_t index = find_context_index
+      (model, pack_key (node < words ? node : CONTEXT_BIT | (node - words),
+                        word_id));
+  return index == -1 ? -1 : words + index;
+}
+
+#endif //TWEETS_MODEL_H_
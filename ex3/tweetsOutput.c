@@ -0,0 +1,109 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "tweetsOutput.h"
+#include "tweetsCommon.h"
+
+#define OUTPUT_BUFFER_SIZE (1 << 20)
+#define MAX_DIGITS 20
+
+/**
+ * Writes the characters to the buffer's file descriptor, bypassing the
+ * buffer.
+ * @param out the buffer
+ * @param data the characters
+ * @param size number of characters
+ */
+void write_output (OutputBuffer *out, const char *data, size_t size)
+{
+  size_t written = 0;
+  while (written < size && out->failed == 0)
+    {
+      ssize_t result = write (out->fd, data + written, size - written);
+      if (result < 0 && errno != EINTR)
+        {
+          out->failed = 1;
+        }
+      if (result > 0)
+        {
+          written += result;
+        }
+    }
+}
+
+/**
+ * Writes the buffered characters and empties the buffer.
+ * @param out the buffer
+ */
+void flush_output (OutputBuffer *out)
+{
+  write_output (out, out->data, out->size);
+  out->size = 0;
+}
+
+/**
+ * Appends the decimal digits of the number to the buffer.
+ * @param out the buffer
+ * @param number the number
+ */
+void append_number (OutputBuffer *out, uint64_t number)
+{
+  char digits[MAX_DIGITS];
+  int start = MAX_DIGITS;
+  do
+    {
+      digits[--start] = (char) ('0' + number % BASE);
+      number /= BASE;
+    }
+  while (number != 0);
+  append_output (out, digits + start, MAX_DIGITS - start);
+}
+
+/**
+ * Opens a buffer that writes to the given file, or to stdout.
+ * @param out the buffer to open
+ * @param path path of the file to write, NULL for stdout
+ * @return 0 on success, 1 if the file can't be opened
+ */
+int open_output (OutputBuffer *out, const char *path)
+{
+  *out = (OutputBuffer) {NULL, 0, 0, STDOUT_FILENO, 0};
+  if (path != NULL)
+    {
+      out->fd = open (path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+      if (out->fd < 0)
+        {
+          return 1;
+        }
+    }
+  out->data = (char *) malloc (OUTPUT_BUFFER_SIZE);
+  if (out->data == NULL)
+    {
+      printf(ALOCATION_FAILURE);
+      exit (EXIT_FAILURE);
+    }
+  out->capacity = OUTPUT_BUFFER_SIZE;
+  return 0;
+}
+
+/**
+ * Writes what is left in the buffer and closes it.
+ * @param out the buffer
+ * @return 0 on success, 1 if a write failed
+ */
+int close_output (OutputBuffer *out)
+{
+  flush_output (out);
+  if (out->fd != STDOUT_FILENO && close (out->fd) != 0)
+    {
+      out->failed = 1;
+    }
+  free (out->data);
+  out->data = NULL;
+  return out->failed;
+}
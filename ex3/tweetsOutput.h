@@ -0,0 +1,105 @@
+#ifndef TWEETS_OUTPUT_H_
+#define TWEETS_OUTPUT_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "tweetsCommon.h"
+
+/*
+ * The buffer tweets and counts are written through.
+ */
+
+/**
+ * @struct OutputBuffer - tweets waiting to be written.
+ * The buffer is written with a single write call whenever it can't fit
+ * another tweet, instead of going through stdio for every word.
+ * @param fd the file descriptor to write to, -1 for a buffer that only
+ * collects tweets in memory and grows as needed.
+ * @param failed 1 if a write failed, 0 otherwise.
+ */
+typedef struct OutputBuffer {
+    char *data;
+    size_t size;
+    size_t capacity;
+    int fd;
+    int failed;
+} OutputBuffer;
+
+/**
+ * Writes the characters to the buffer's file descriptor, bypassing the
+ * buffer.
+ * @param out the buffer
+ * @param data the characters
+ * @param size number of characters
+ */
+void write_output (OutputBuffer *out, const char *data, size_t size);
+
+/**
+ * Writes the buffered characters and empties the buffer.
+ * @param out the buffer
+ */
+void flush_output (OutputBuffer *out);
+
+/**
+ * Appends the decimal digits of the number to the buffer.
+ * @param out the buffer
+ * @param number the number
+ */
+void append_number (OutputBuffer *out, uint64_t number);
+
+/**
+ * Opens a buffer that writes to the given file, or to stdout.
+ * @param out the buffer to open
+ * @param path path of the file to write, NULL for stdout
+ * @return 0 on success, 1 if the file can't be opened
+ */
+int open_output (OutputBuffer *out, const char *path);
+
+/**
+ * Writes what is left in the buffer and closes it.
+ * @param out the buffer
+ * @return 0 on success, 1 if a write failed
+ */
+int close_output (OutputBuffer *out);
+
+/*
+ * Every word generated is appended to a buffer, so appending is defined
+ * here, inline.
+ */
+
+/**
+ * Appends characters to the buffer, making room for them first if needed.
+ * @param out the buffer
+ * @param text the characters
+ * @param length number of characters
+ */
+static inline void append_output (OutputBuffer *out, const char *text,
+                                  size_t length)
+{
+  if (out->capacity - out->size < length)
+    {
+      if (out->fd >= 0)
+        {
+          flush_output (out);
+        }
+      if (out->capacity - out->size < length)
+        {
+          size_t capacity = out->capacity * 2 > out->size + length
+                            ? out->capacity * 2 : out->size + length;
+          char *temp = (char *) realloc (out->data, capacity);
+          if (temp == NULL)
+            {
+              printf(ALOCATION_FAILURE);
+              exit (EXIT_FAILURE);
+            }
+          out->data = temp;
+          out->capacity = capacity;
+        }
+    }
+  memcpy (out->data + out->size, text, length);
+  out->size += length;
+}
+
+#endif //TWEETS_OUTPUT_H_
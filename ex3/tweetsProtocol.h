@@ -0,0 +1,107 @@
+#ifndef TWEETS_PROTOCOL_H_
+#define TWEETS_PROTOCOL_H_
+
+#include <stdint.h>
+#include <time.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+/*
+ * What the server mode of tweetsGenerator and the clients of loadGenerator
+ * share: the messages they exchange, the helpers that send and receive them
+ * whole, and the clock both time themselves by. Both programs define
+ * _POSIX_C_SOURCE before including it.
+ */
+
+#define STATUS_OK 0
+#define STATUS_TOO_MANY_TWEETS 1
+#define STATUS_TOO_LARGE 2
+
+/**
+ * @struct Request - asks the server for tweets: the tweets 1 to
+ * num_of_tweets of a run with the given seed. Requests and responses are
+ * sent in the byte order of the machine, since the socket is local.
+ */
+typedef struct Request {
+    uint32_t num_of_tweets;
+    int32_t seed;
+} Request;
+
+/**
+ * @struct Response - the answer to a request, followed by size characters
+ * of tweets, exactly what the program would print for the same seed and
+ * number of tweets.
+ * @param status STATUS_OK, STATUS_TOO_MANY_TWEETS if more than
+ * MAX_REQUEST_TWEETS were asked for, or STATUS_TOO_LARGE if the tweets come
+ * to more than UINT32_MAX characters, in which case no tweets follow.
+ * @param size number of characters of tweets that follow, at most
+ * UINT32_MAX, which bounds the tweets of a single request.
+ */
+typedef struct Response {
+    uint32_t status;
+    uint32_t size;
+} Response;
+
+/**
+ * @return the current monotonic time in seconds
+ */
+static inline double get_time (void)
+{
+  struct timespec now;
+  clock_gettime (CLOCK_MONOTONIC, &now);
+  return (double) now.tv_sec + (double) now.tv_nsec / 1e9;
+}
+
+/**
+ * Reads exactly size bytes from the socket.
+ * @param fd the socket
+ * @param data where to read to
+ * @param size number of bytes
+ * @return 0 on success, 1 if the connection ended or failed first
+ */
+static inline int receive_all (int fd, void *data, size_t size)
+{
+  size_t done = 0;
+  while (done < size)
+    {
+      ssize_t result = recv (fd, (char *) data + done, size - done, 0);
+      if (result == 0 || (result < 0 && errno != EINTR))
+        {
+          return 1;
+        }
+      if (result > 0)
+        {
+          done += result;
+        }
+    }
+  return 0;
+}
+
+/**
+ * Writes exactly size bytes to the socket.
+ * @param fd the socket
+ * @param data what to write
+ * @param size number of bytes
+ * @return 0 on success, 1 if the connection failed
+ */
+static inline int send_all (int fd, const void *data, size_t size)
+{
+  size_t done = 0;
+  while (done < size)
+    {
+      ssize_t result = send (fd, (const char *) data + done, size - done,
+                             MSG_NOSIGNAL);
+      if (result < 0 && errno != EINTR)
+        {
+          return 1;
+        }
+      if (result > 0)
+        {
+          done += result;
+        }
+    }
+  return 0;
+}
+
+#endif //TWEETS_PROTOCOL_H_
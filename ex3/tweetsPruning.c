@@ -0,0 +1,182 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "tweetsPruning.h"
+#include "tweetsCommon.h"
+#include "tweetsStats.h"
+
+#define PRUNE_REPORT "Pruned %d of %d words and %llu of %llu successors: \
+%.1f MB -> %.1f MB, %.1f MB saved\n"
+
+/**
+ * compares occurrence counts for sorting them from the largest down
+ * @param a, b pointers to the counts
+ * @return negative if a comes first, positive if b does, 0 if equal
+ */
+int compare_counts (const void *a, const void *b)
+{
+  int first = *(const int *) a;
+  int second = *(const int *) b;
+  return (second > first) - (second < first);
+}
+
+/**
+ * Finds the smallest occurrence count a word may have to be kept, and how
+ * many words of exactly that count are kept, so that at most max_words of
+ * the words seen at least min_count times are kept. Words of the same count
+ * are kept in the order of their ids.
+ * @param dictionary the dictionary
+ * @param pruning the limits
+ * @param ties set to the number of words of the returned count to keep, or
+ * to -1 if all of them are kept
+ * @return the smallest count of a kept word
+ */
+int find_cutoff (const Dictionary *dictionary, const Pruning *pruning,
+                 int *ties)
+{
+  *ties = -1;
+  int *counts = (int *) malloc ((dictionary->size + 1) * sizeof (int));
+  if (counts == NULL)
+    {
+      printf(ALOCATION_FAILURE);
+      exit (EXIT_FAILURE);
+    }
+  int candidates = 0;
+  for (int id = 0; id < dictionary->size; ++id)
+    {
+      if (dictionary->words[id].number_of_occurrence >= pruning->min_count)
+        {
+          counts[candidates++] = dictionary->words[id].number_of_occurrence;
+        }
+    }
+  int cutoff = pruning->min_count;
+  if (pruning->max_words > 0 && candidates > pruning->max_words)
+    {
+      qsort (counts, candidates, sizeof (int), compare_counts);
+      cutoff = counts[pruning->max_words - 1];
+      int above = 0;
+      while (counts[above] > cutoff)
+        {
+          above++;
+        }
+      *ties = pruning->max_words - above;
+    }
+  free (counts);
+  return cutoff;
+}
+
+/**
+ * Builds a dictionary of the words of the given one that survive the
+ * pruning, with the successors and contexts made only of surviving words
+ * and seen at least min_count times. The surviving words keep their order
+ * but get consecutive ids, and everything is copied into a new dictionary,
+ * so nothing of the dropped words is left behind. Its arrays grow as the
+ * words are added, like any dictionary's, so they may keep some slack.
+ * A context whose successors were all dropped is kept, since longer
+ * contexts may extend it; generation backs off from its empty row.
+ * @param dictionary the dictionary to prune, left as is
+ * @param pruning the limits
+ * @return the pruned dictionary, on the heap
+ */
+Dictionary *prune_dictionary (const Dictionary *dictionary,
+                              const Pruning *pruning)
+{
+  int ties = 0;
+  int cutoff = find_cutoff (dictionary, pruning, &ties);
+  int *to_pruned = (int *) malloc ((dictionary->size + 1) * sizeof (int));
+  uint32_t *context_to_pruned = (uint32_t *) malloc
+      ((dictionary->contexts.size + 1) * sizeof (uint32_t));
+  if (to_pruned == NULL || context_to_pruned == NULL)
+    {
+      printf(ALOCATION_FAILURE);
+      exit (EXIT_FAILURE);
+    }
+  Dictionary *pruned = new_dictionary (dictionary->order);
+  for (int id = 0; id < dictionary->size; ++id)
+    {
+      const WordStruct *word = &dictionary->words[id];
+      to_pruned[id] = -1;
+      if (word->number_of_occurrence < cutoff
+          || (word->number_of_occurrence == cutoff && ties == 0))
+        {
+          continue;
+        }
+      if (word->number_of_occurrence == cutoff && ties > 0)
+        {
+          ties--;
+        }
+      WordStruct *kept = intern_word (pruned, word->word, word->length);
+      kept->number_of_occurrence = word->number_of_occurrence;
+      to_pruned[id] = kept->id;
+    }
+  for (int id = 0; id < dictionary->size; ++id)
+    {
+      const WordStruct *word = &dictionary->words[id];
+      for (int i = 0; to_pruned[id] != -1 && i < word->prob_list_size; ++i)
+        {
+          const WordProbability *next = &word->prob_list[i];
+          if (to_pruned[next->word_id] != -1
+              && next->num_of_occurrnces >= pruning->min_count)
+            {
+              add_successor (&pruned->words[to_pruned[id]],
+                             to_pruned[next->word_id],
+                             next->num_of_occurrnces);
+            }
+        }
+    }
+  for (uint32_t i = 0; i < dictionary->contexts.size; ++i)
+    {
+      uint32_t node = dictionary->contexts.keys[i] >> 32;
+      int word_id = to_pruned[(uint32_t) dictionary->contexts.keys[i]];
+      node = (node & CONTEXT_BIT) ? context_to_pruned[node & ~CONTEXT_BIT]
+                                  : (uint32_t) to_pruned[node];
+      context_to_pruned[i] = node == (uint32_t) -1 || word_id == -1
+                             ? (uint32_t) -1
+                             : intern_context (pruned, node, word_id);
+    }
+  for (uint32_t i = 0; i < dictionary->ngrams.size; ++i)
+    {
+      uint32_t node = context_to_pruned[(dictionary->ngrams.keys[i] >> 32)
+                                        & ~CONTEXT_BIT];
+      int word_id = to_pruned[(uint32_t) dictionary->ngrams.keys[i]];
+      if (node == (uint32_t) -1 || word_id == -1
+          || dictionary->ngrams.counts[i] < (uint32_t) pruning->min_count)
+        {
+          continue;
+        }
+      uint32_t index = find_or_add_ngram (&pruned->ngrams,
+                                          pack_key (node, word_id));
+      pruned->ngrams.counts[index] = dictionary->ngrams.counts[i];
+    }
+  free (context_to_pruned);
+  free (to_pruned);
+  return pruned;
+}
+
+/**
+ * Prunes the dictionary if the pruning drops anything, and reports to
+ * stderr what was dropped and how much memory that saved, which is negative
+ * if the slack of the new arrays outweighs what was dropped.
+ * @param dictionary the dictionary, freed if it is pruned
+ * @param pruning the limits
+ * @return the pruned dictionary, or the given one if there is no limit
+ */
+Dictionary *apply_pruning (Dictionary *dictionary, const Pruning *pruning)
+{
+  if (pruning->min_count <= 1 && pruning->max_words == 0)
+    {
+      return dictionary;
+    }
+  Dictionary *pruned = prune_dictionary (dictionary, pruning);
+  size_t before = dictionary_bytes (dictionary);
+  size_t after = dictionary_bytes (pruned);
+  fprintf (stderr, PRUNE_REPORT, dictionary->size - pruned->size,
+           dictionary->size,
+           (unsigned long long) (dictionary_edges (dictionary)
+                                 - dictionary_edges (pruned)),
+           (unsigned long long) dictionary_edges (dictionary),
+           (double) before / MEGABYTE, (double) after / MEGABYTE,
+           ((double) before - (double) after) / MEGABYTE);
+  free_dictionary (dictionary);
+  return pruned;
+}
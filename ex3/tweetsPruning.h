@@ -0,0 +1,33 @@
+#ifndef TWEETS_PRUNING_H_
+#define TWEETS_PRUNING_H_
+
+#include "tweetsDictionary.h"
+
+/*
+ * Dropping the rare words and successors of a dictionary before it is
+ * frozen.
+ */
+
+/**
+ * @struct Pruning - which words and successors are kept in the model.
+ * @param min_count words and successors seen fewer times than this are
+ * dropped, 1 keeps all of them.
+ * @param max_words at most this many of the most frequent words are kept,
+ * 0 for no limit.
+ */
+typedef struct Pruning {
+    int min_count;
+    int max_words;
+} Pruning;
+
+/**
+ * Prunes the dictionary if the pruning drops anything, and reports to
+ * stderr what was dropped and how much memory that saved, which is negative
+ * if the slack of the new arrays outweighs what was dropped.
+ * @param dictionary the dictionary, freed if it is pruned
+ * @param pruning the limits
+ * @return the pruned dictionary, or the given one if there is no limit
+ */
+Dictionary *apply_pruning (Dictionary *dictionary, const Pruning *pruning);
+
+#endif //TWEETS_PRUNING_H_
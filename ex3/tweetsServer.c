@@ -0,0 +1,159 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <signal.h>
+#include "tweetsProtocol.h"
+#include "tweetsServer.h"
+#include "tweetsCommon.h"
+
+#define SERVER_BACKLOG 64
+#define SERVER_REPORT "Serving on %s with %d threads\n"
+
+/**
+ * @struct ServerTask - what the threads of the server share.
+ * @param listener the listening socket every thread accepts from.
+ */
+typedef struct ServerTask {
+    int listener;
+    const Model *model;
+    const Constraint *constraint;
+} ServerTask;
+
+/**
+ * Answers the requests of a client until it disconnects. The tweets of a
+ * request are collected in out, which is kept between requests so its
+ * memory is reused.
+ * @param client the client's socket
+ * @param model the model
+ * @param constraint the constraint every tweet must meet, NULL for none
+ * @param out a memory only buffer
+ */
+void serve_client (int client, const Model *model,
+                   const Constraint *constraint, OutputBuffer *out)
+{
+  Request request;
+  while (receive_all (client, &request, sizeof (Request)) == 0)
+    {
+      Response response = {STATUS_OK, 0};
+      out->size = 0;
+      if (request.num_of_tweets > MAX_REQUEST_TWEETS)
+        {
+          response.status = STATUS_TOO_MANY_TWEETS;
+        }
+      else
+        {
+          create_tweets (1, (int) request.num_of_tweets, request.seed, model,
+                         constraint, out);
+          // the size is sent in 32 bits, so larger tweets can't be sent
+          if (out->size > UINT32_MAX)
+            {
+              response.status = STATUS_TOO_LARGE;
+            }
+          else
+            {
+              response.size = (uint32_t) out->size;
+            }
+        }
+      if (send_all (client, &response, sizeof (Response)) != 0
+          || send_all (client, out->data, response.size) != 0)
+        {
+          return;
+        }
+    }
+}
+
+/**
+ * Thread entry point of the server's pool: accepts clients from the shared
+ * listening socket and serves them one at a time.
+ * @param arg the ServerTask
+ * @return NULL
+ */
+void *serve_connections (void *arg)
+{
+  const ServerTask *task = (const ServerTask *) arg;
+  OutputBuffer out = {NULL, 0, 0, -1, 0};
+  while (1)
+    {
+      int client = accept (task->listener, NULL, NULL);
+      if (client < 0)
+        {
+          if (errno == EINTR || errno == ECONNABORTED)
+            {
+              continue;
+            }
+          break;
+        }
+      serve_client (client, task->model, task->constraint, &out);
+      close (client);
+    }
+  free (out.data);
+  return NULL;
+}
+
+/**
+ * Serves tweets from the model over a Unix domain socket at the given path
+ * until the process gets SIGINT or SIGTERM. Every thread of the pool serves
+ * one client at a time, so up to threads clients are answered at once.
+ * The threads may still be answering when this returns, so the model must
+ * be left to the exit of the process.
+ * @param model the model
+ * @param constraint the constraint every tweet must meet, NULL for none
+ * @param path path of the socket, replaced if it exists
+ * @param threads number of threads in the pool
+ * @return 0 after a signal, 1 if the socket can't be set up
+ */
+int serve (const Model *model, const Constraint *constraint,
+           const char *path, int threads)
+{
+  struct sockaddr_un address;
+  memset (&address, 0, sizeof (address));
+  address.sun_family = AF_UNIX;
+  if (strlen (path) >= sizeof (address.sun_path))
+    {
+      return 1;
+    }
+  strcpy (address.sun_path, path);
+  ServerTask task = {socket (AF_UNIX, SOCK_STREAM, 0), model, constraint};
+  unlink (path);
+  if (task.listener < 0
+      || bind (task.listener, (struct sockaddr *) &address,
+               sizeof (address)) != 0
+      || listen (task.listener, SERVER_BACKLOG) != 0)
+    {
+      return 1;
+    }
+  // the signals are blocked before the pool starts, so that every thread
+  // inherits the mask and only sigwait below receives them
+  sigset_t signals;
+  sigemptyset (&signals);
+  sigaddset (&signals, SIGINT);
+  sigaddset (&signals, SIGTERM);
+  pthread_sigmask (SIG_BLOCK, &signals, NULL);
+  pthread_t workers[MAX_THREADS];
+  int started = 0;
+  while (started < threads
+         && pthread_create (&workers[started], NULL, serve_connections,
+                            &task) == 0)
+    {
+      started++;
+    }
+  if (started == 0)
+    {
+      close (task.listener);
+      unlink (path);
+      return 1;
+    }
+  fprintf (stderr, SERVER_REPORT, path, started);
+  int signal_number = 0;
+  sigwait (&signals, &signal_number);
+  shutdown (task.listener, SHUT_RDWR);
+  unlink (path);
+  return 0;
+}
@@ -0,0 +1,28 @@
+#ifndef TWEETS_SERVER_H_
+#define TWEETS_SERVER_H_
+
+#include "tweetsGeneration.h"
+
+/*
+ * Serving tweets over a Unix domain socket, with the messages of
+ * tweetsProtocol.h.
+ */
+
+#define MAX_REQUEST_TWEETS (1 << 20)
+
+/**
+ * Serves tweets from the model over a Unix domain socket at the given path
+ * until the process gets SIGINT or SIGTERM. Every thread of the pool serves
+ * one client at a time, so up to threads clients are answered at once.
+ * The threads may still be answering when this returns, so the model must
+ * be left to the exit of the process.
+ * @param model the model
+ * @param constraint the constraint every tweet must meet, NULL for none
+ * @param path path of the socket, replaced if it exists
+ * @param threads number of threads in the pool
+ * @return 0 after a signal, 1 if the socket can't be set up
+ */
+int serve (const Model *model, const Constraint *constraint,
+           const char *path, int threads);
+
+#endif //TWEETS_SERVER_H_
@@ -0,0 +1,210 @@
+#include <stdio.h>
+#include <stdint.h>
+#include "tweetsStats.h"
+
+#define NGRAM_REPORT "Model of order %u: %u words, %u contexts, %.1f bytes \
+per context\n"
+
+const char *const PHASE_NAMES[PHASE_COUNT] = {
+    "load", "thaw", "ingest", "prune", "freeze", "save", "generate"
+};
+
+const char *const PART_NAMES[DICTIONARY_PART_COUNT] = {
+    "words", "word_slots", "arena", "prob_lists", "successor_slots",
+    "starters", "contexts", "ngrams"
+};
+
+const char *const SECTION_NAMES[SECTION_COUNT] = {
+    "text", "text_offsets", "occurrences", "starters", "rows", "successors",
+    "cumulative", "alias", "context_keys", "context_indices"
+};
+
+/**
+ * @param table the table
+ * @return the number of bytes the table holds on the heap
+ */
+size_t ngram_table_bytes (const NgramTable *table)
+{
+  return (size_t) table->capacity * (sizeof (uint64_t) + sizeof (uint32_t))
+         + (size_t) table->slots_capacity * sizeof (uint32_t);
+}
+
+/**
+ * Measures the bytes every structure of the dictionary holds on the heap.
+ * @param dictionary the dictionary
+ * @param bytes filled with the bytes of every DictionaryPart
+ */
+void measure_dictionary (const Dictionary *dictionary,
+                         size_t bytes[DICTIONARY_PART_COUNT])
+{
+  bytes[PART_WORDS] = sizeof (Dictionary)
+                      + (size_t) dictionary->capacity * sizeof (WordStruct);
+  bytes[PART_WORD_SLOTS] = (size_t) dictionary->word_slots_capacity
+                           * sizeof (int);
+  bytes[PART_ARENA] = 0;
+  for (ArenaBlock *block = dictionary->arena; block != NULL;
+       block = block->next)
+    {
+      bytes[PART_ARENA] += sizeof (ArenaBlock) + block->capacity;
+    }
+  bytes[PART_PROB_LISTS] = 0;
+  bytes[PART_SUCCESSOR_SLOTS] = 0;
+  for (int id = 0; id < dictionary->size; ++id)
+    {
+      const WordStruct *word = &dictionary->words[id];
+      bytes[PART_PROB_LISTS] += (size_t) word->prob_list_capacity
+                                * sizeof (WordProbability);
+      bytes[PART_SUCCESSOR_SLOTS] += (size_t) word->successor_slots_capacity
+                                     * sizeof (int);
+    }
+  bytes[PART_STARTERS] = (size_t) dictionary->starters_capacity
+                         * sizeof (int);
+  bytes[PART_CONTEXTS] = ngram_table_bytes (&dictionary->contexts);
+  bytes[PART_NGRAMS] = ngram_table_bytes (&dictionary->ngrams);
+}
+
+/**
+ * @param dictionary the dictionary
+ * @return the number of bytes the dictionary holds on the heap
+ */
+size_t dictionary_bytes (const Dictionary *dictionary)
+{
+  size_t bytes[DICTIONARY_PART_COUNT];
+  measure_dictionary (dictionary, bytes);
+  size_t total = 0;
+  for (int i = 0; i < DICTIONARY_PART_COUNT; ++i)
+    {
+      total += bytes[i];
+    }
+  return total;
+}
+
+/**
+ * @param dictionary the dictionary
+ * @return the number of words read into the dictionary
+ */
+uint64_t count_tokens (const Dictionary *dictionary)
+{
+  uint64_t tokens = 0;
+  for (int id = 0; id < dictionary->size; ++id)
+    {
+      tokens += dictionary->words[id].number_of_occurrence;
+    }
+  return tokens;
+}
+
+/**
+ * @param dictionary the dictionary
+ * @return the number of successors of all the words and contexts
+ */
+uint64_t dictionary_edges (const Dictionary *dictionary)
+{
+  uint64_t edges = dictionary->ngrams.size;
+  for (int id = 0; id < dictionary->size; ++id)
+    {
+      edges += dictionary->words[id].prob_list_size;
+    }
+  return edges;
+}
+
+/**
+ * Reports the size of the model's contexts to stderr.
+ * @param model the model
+ */
+void report_model (const Model *model)
+{
+  const ModelHeader *header = model->header;
+  uint64_t context_edges = model->rows[header->word_count
+                                       + header->context_count]
+                           - model->rows[header->word_count];
+  // a row offset and two table slots per context, and the successor id,
+  // running sum and alias entry of each of its successors
+  uint64_t bytes = header->context_count * sizeof (uint64_t)
+                   + header->context_slots * (sizeof (uint64_t)
+                                              + sizeof (uint32_t))
+                   + context_edges * (2 * sizeof (uint32_t)
+                                      + sizeof (AliasEntry));
+  fprintf (stderr, NGRAM_REPORT, header->order, header->word_count,
+           header->context_count, header->context_count == 0
+                                  ? 0 : (double) bytes / header->context_count);
+}
+
+/**
+ * @param count number of things done
+ * @param seconds the time they took
+ * @return the number of things done per second, 0 if no time passed
+ */
+double rate_of (uint64_t count, double seconds)
+{
+  return seconds > 0 ? (double) count / seconds : 0;
+}
+
+/**
+ * Reports the stats of the run to stderr, as text or as a JSON object.
+ * @param stats what the run measured
+ * @param model the model of the run
+ * @param format STATS_TEXT or STATS_JSON
+ */
+void report_stats (const Stats *stats, const Model *model, StatsFormat format)
+{
+  const ModelHeader *header = model->header;
+  uint64_t bigrams = model->rows[header->word_count] - model->rows[0];
+  uint64_t max_fan_out = 0;
+  for (uint32_t id = 0; id < header->word_count; ++id)
+    {
+      uint64_t fan_out = model->rows[id + 1] - model->rows[id];
+      max_fan_out = fan_out > max_fan_out ? fan_out : max_fan_out;
+    }
+  uint64_t context_edges = model->rows[header->word_count
+                                       + header->context_count]
+                           - model->rows[header->word_count];
+  double fan_out = header->word_count == 0
+                   ? 0 : (double) bigrams / header->word_count;
+  uint64_t sections[SECTION_COUNT];
+  for (int i = 0; i < SECTION_COUNT; ++i)
+    {
+      sections[i] = (i + 1 < SECTION_COUNT ? header->sections[i + 1]
+                                           : header->size)
+                    - header->sections[i];
+    }
+  int json = format == STATS_JSON;
+  fprintf (stderr, json ? "{\"phases\": {" : "Phases:\n");
+  for (int i = 0; i < PHASE_COUNT; ++i)
+    {
+      fprintf (stderr, json ? "%s\"%s\": %.6f" : "%s  %-16s %.6f s\n",
+               json && i > 0 ? ", " : "", PHASE_NAMES[i], stats->phases[i]);
+    }
+  fprintf (stderr, json ? "}, \"tokens\": %llu, \"tokens_per_sec\": %.0f, "
+                          "\"words\": %u, \"bigrams\": %llu, "
+                          "\"fan_out_average\": %.3f, \"fan_out_max\": %llu, "
+                          "\"contexts\": %u, \"context_successors\": %llu, "
+                          "\"tweets\": %llu, \"tweets_per_sec\": %.0f, "
+                          "\"dictionary_bytes\": {"
+                        : "Tokens: %llu read (%.0f tokens/sec)\n"
+                          "Words: %u unique, %llu bigrams, fan-out %.3f "
+                          "average, %llu max\n"
+                          "Contexts: %u, with %llu successors\n"
+                          "Tweets: %llu generated (%.0f tweets/sec)\n"
+                          "Dictionary bytes:\n",
+           (unsigned long long) stats->tokens,
+           rate_of (stats->tokens, stats->phases[PHASE_INGEST]),
+           header->word_count, (unsigned long long) bigrams, fan_out,
+           (unsigned long long) max_fan_out, header->context_count,
+           (unsigned long long) context_edges,
+           (unsigned long long) stats->tweets,
+           rate_of (stats->tweets, stats->phases[PHASE_GENERATE]));
+  for (int i = 0; i < DICTIONARY_PART_COUNT; ++i)
+    {
+      fprintf (stderr, json ? "%s\"%s\": %llu" : "%s  %-16s %llu\n",
+               json && i > 0 ? ", " : "", PART_NAMES[i],
+               (unsigned long long) stats->dictionary_bytes[i]);
+    }
+  fprintf (stderr, json ? "}, \"model_bytes\": {" : "Model bytes:\n");
+  for (int i = 0; i < SECTION_COUNT; ++i)
+    {
+      fprintf (stderr, json ? "%s\"%s\": %llu" : "%s  %-16s %llu\n",
+               json && i > 0 ? ", " : "", SECTION_NAMES[i],
+               (unsigned long long) sections[i]);
+    }
+  fprintf (stderr, json ? "}}\n" : "");
+}
@@ -0,0 +1,112 @@
+#ifndef TWEETS_STATS_H_
+#define TWEETS_STATS_H_
+
+#include <stdint.h>
+#include "tweetsModel.h"
+
+/*
+ * What a run measures, and the reports of --bench and --stats.
+ */
+
+/**
+ * @enum Phase - the timed phases of a run, in the order they happen.
+ */
+typedef enum Phase {
+    PHASE_LOAD,
+    PHASE_THAW,
+    PHASE_INGEST,
+    PHASE_PRUNE,
+    PHASE_FREEZE,
+    PHASE_SAVE,
+    PHASE_GENERATE,
+    PHASE_COUNT
+} Phase;
+
+/**
+ * @enum DictionaryPart - the structures of a dictionary that hold memory.
+ */
+typedef enum DictionaryPart {
+    PART_WORDS,
+    PART_WORD_SLOTS,
+    PART_ARENA,
+    PART_PROB_LISTS,
+    PART_SUCCESSOR_SLOTS,
+    PART_STARTERS,
+    PART_CONTEXTS,
+    PART_NGRAMS,
+    DICTIONARY_PART_COUNT
+} DictionaryPart;
+
+/**
+ * @enum StatsFormat - how the stats of a run are reported.
+ */
+typedef enum StatsFormat {
+    STATS_NONE,
+    STATS_TEXT,
+    STATS_JSON
+} StatsFormat;
+
+/**
+ * @struct Stats - what a run measures along the way. The rest of the report
+ * is read off the model.
+ * @param phases seconds spent in every Phase.
+ * @param tokens number of words read from corpus files.
+ * @param dictionary_bytes bytes of every DictionaryPart of the last
+ * dictionary read into, at its largest: before it is pruned.
+ * @param tweets number of tweets generated.
+ */
+typedef struct Stats {
+    double phases[PHASE_COUNT];
+    uint64_t tokens;
+    size_t dictionary_bytes[DICTIONARY_PART_COUNT];
+    uint64_t tweets;
+} Stats;
+
+/**
+ * Measures the bytes every structure of the dictionary holds on the heap.
+ * @param dictionary the dictionary
+ * @param bytes filled with the bytes of every DictionaryPart
+ */
+void measure_dictionary (const Dictionary *dictionary,
+                         size_t bytes[DICTIONARY_PART_COUNT]);
+
+/**
+ * @param dictionary the dictionary
+ * @return the number of bytes the dictionary holds on the heap
+ */
+size_t dictionary_bytes (const Dictionary *dictionary);
+
+/**
+ * @param dictionary the dictionary
+ * @return the number of words read into the dictionary
+ */
+uint64_t count_tokens (const Dictionary *dictionary);
+
+/**
+ * @param dictionary the dictionary
+ * @return the number of successors of all the words and contexts
+ */
+uint64_t dictionary_edges (const Dictionary *dictionary);
+
+/**
+ * Reports the size of the model's contexts to stderr.
+ * @param model the model
+ */
+void report_model (const Model *model);
+
+/**
+ * @param count number of things done
+ * @param seconds the time they took
+ * @return the number of things done per second, 0 if no time passed
+ */
+double rate_of (uint64_t count, double seconds);
+
+/**
+ * Reports the stats of the run to stderr, as text or as a JSON object.
+ * @param stats what the run measured
+ * @param model the model of the run
+ * @param format STATS_TEXT or STATS_JSON
+ */
+void report_stats (const Stats *stats, const Model *model, StatsFormat format);
+
+#endif //TWEETS_STATS_H_
@@ -0,0 +1,545 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "tweetsUpdate.h"
+#include "tweetsCommon.h"
+
+/**
+ * Adds the successors of a row of the model to the prob_list of a word, or
+ * of a row being updated, in their order.
+ * @param model the model
+ * @param node the word or context of the row
+ * @param word the word to add them to
+ */
+void thaw_row (const Model *model, uint32_t node, WordStruct *word)
+{
+  uint64_t low = model->rows[node];
+  for (uint64_t e = low; e < model->rows[node + 1]; ++e)
+    {
+      add_successor (word, (int) model->successors[e],
+                     (int) count_of (model, low, e));
+    }
+}
+
+/**
+ * Rebuilds the dictionary a model was frozen from, so more of the corpus can
+ * be read into it. Words get back their ids, prob_lists and contexts keep
+ * their order, and the counts are the differences of the running sums, so
+ * reading a file into the result is the same as having read it after the
+ * corpus of the model. The ngrams come back grouped by context, which is
+ * the order freezing puts them in anyway.
+ * @param model the model
+ * @return the dictionary, on the heap
+ */
+Dictionary *thaw_model (const Model *model)
+{
+  const ModelHeader *header = model->header;
+  Dictionary *dictionary = new_dictionary ((int) header->order);
+  for (uint32_t id = 0; id < header->word_count; ++id)
+    {
+      WordStruct *word = intern_word (dictionary, word_text (model, id),
+                                      (int) word_length (model, id));
+      word->number_of_occurrence = (int) model->occurrences[id];
+    }
+  for (uint32_t id = 0; id < header->word_count; ++id)
+    {
+      thaw_row (model, id, &dictionary->words[id]);
+    }
+  uint64_t *keys = (uint64_t *) malloc (((size_t) header->context_count + 1)
+                                        * sizeof (uint64_t));
+  if (keys == NULL)
+    {
+      printf(ALOCATION_FAILURE);
+      exit (EXIT_FAILURE);
+    }
+  for (uint32_t slot = 0; slot < header->context_slots; ++slot)
+    {
+      if (model->context_keys[slot] != EMPTY_KEY)
+        {
+          keys[model->context_indices[slot]] = model->context_keys[slot];
+        }
+    }
+  // a context always comes after the context it extends, so interning them
+  // in order gives every context its index back
+  for (uint32_t i = 0; i < header->context_count; ++i)
+    {
+      intern_context (dictionary, keys[i] >> 32, (uint32_t) keys[i]);
+    }
+  free (keys);
+  for (uint32_t i = 0; i < header->context_count; ++i)
+    {
+      uint32_t node = header->word_count + i;
+      for (uint64_t e = model->rows[node]; e < model->rows[node + 1]; ++e)
+        {
+          uint32_t index = find_or_add_ngram
+              (&dictionary->ngrams, pack_key (CONTEXT_BIT | i,
+                                              model->successors[e]));
+          dictionary->ngrams.counts[index] += count_of (model,
+                                                        model->rows[node], e);
+        }
+    }
+  return dictionary;
+}
+
+/**
+ * Maps the words of the file to their ids in the updated model. The
+ * model's words are looked up in the file's dictionary straight from the
+ * model's text, stopping once every word of the file is found. The words
+ * the model doesn't have get the next ids in the order the file has them,
+ * as they would if the file was read into the thawed model.
+ * @param model the model
+ * @param update the update, with its delta filled
+ */
+void map_words (const Model *model, Update *update)
+{
+  Dictionary *delta = update->delta;
+  uint32_t words = model->header->word_count;
+  update->to_word = (uint32_t *) malloc ((delta->size + 1)
+                                         * sizeof (uint32_t));
+  if (update->to_word == NULL)
+    {
+      printf(ALOCATION_FAILURE);
+      exit (EXIT_FAILURE);
+    }
+  for (int id = 0; id < delta->size; ++id)
+    {
+      update->to_word[id] = UINT32_MAX;
+    }
+  int found = 0;
+  for (uint32_t id = 0; id < words && found < delta->size; ++id)
+    {
+      WordStruct *word = check_word (delta, word_text (model, id),
+                                     (int) word_length (model, id));
+      if (word != NULL)
+        {
+          update->to_word[word->id] = id;
+          found++;
+        }
+    }
+  update->added_words = 0;
+  for (int id = 0; id < delta->size; ++id)
+    {
+      if (update->to_word[id] == UINT32_MAX)
+        {
+          update->to_word[id] = words + update->added_words++;
+        }
+    }
+}
+
+/**
+ * @param update the update, with its words and the contexts the key's node
+ * may be mapped
+ * @param key a key of the contexts or ngrams of the file's dictionary
+ * @return the key of the same context or ngram in the updated model
+ */
+uint64_t map_key (const Update *update, uint64_t key)
+{
+  uint32_t node = key >> 32;
+  if (node & CONTEXT_BIT)
+    {
+      node = CONTEXT_BIT | update->to_context[node & ~CONTEXT_BIT];
+    }
+  else
+    {
+      node = update->to_word[node];
+    }
+  return pack_key (node, update->to_word[(uint32_t) key]);
+}
+
+/**
+ * Maps the contexts of the file to their indices in the updated model,
+ * looking them up in the model's context table. A context comes after the
+ * context it extends, so its key can always be mapped, and the contexts
+ * the model doesn't have get the next indices in the order of the file.
+ * @param model the model
+ * @param update the update, with its words mapped
+ */
+void map_contexts (const Model *model, Update *update)
+{
+  const NgramTable *contexts = &update->delta->contexts;
+  update->to_context = (uint32_t *) malloc ((contexts->size + 1)
+                                            * sizeof (uint32_t));
+  if (update->to_context == NULL)
+    {
+      printf(ALOCATION_FAILURE);
+      exit (EXIT_FAILURE);
+    }
+  update->added_contexts = 0;
+  for (uint32_t i = 0; i < contexts->size; ++i)
+    {
+      int64_t index = find_context_index (model, map_key (update,
+                                                          contexts->keys[i]));
+      update->to_context[i] = index != -1 ? (uint32_t) index
+                                          : model->header->context_count
+                                            + update->added_contexts++;
+    }
+}
+
+/**
+ * Starts the updated row of a node the file adds successors to, with the
+ * successors the model has for it.
+ * @param model the model
+ * @param update the update
+ * @param node the node in the updated model
+ * @param previous the node in the model, UINT32_MAX if it is new
+ * @return the row
+ */
+WordStruct *add_dirty_row (const Model *model, Update *update, uint32_t node,
+                           uint32_t previous)
+{
+  uint32_t index = update->dirty_size++;
+  update->dirty[index] = pack_key (node, index);
+  WordStruct *row = &update->rows[index];
+  if (previous != UINT32_MAX)
+    {
+      thaw_row (model, previous, row);
+    }
+  return row;
+}
+
+/**
+ * compares two keys of the dirty rows, by node
+ * @param a, b the keys
+ * @return negative, 0 or positive, as a is before, with or after b
+ */
+int compare_keys (const void *a, const void *b)
+{
+  uint64_t first = *(const uint64_t *) a;
+  uint64_t second = *(const uint64_t *) b;
+  return (first > second) - (first < second);
+}
+
+/**
+ * Builds the updated rows of every node the file adds successors to: the
+ * model's successors of the node are thawed, then the file's are added, in
+ * the order the file first has them, so every row ends up as it would in
+ * the thawed model. The other rows stay frozen.
+ * @param model the model
+ * @param update the update, with its words and contexts mapped
+ */
+void merge_rows (const Model *model, Update *update)
+{
+  const Dictionary *delta = update->delta;
+  uint32_t words = model->header->word_count;
+  uint32_t nodes = words + update->added_words;
+  size_t most = (size_t) delta->size + delta->contexts.size + 1;
+  update->rows = (WordStruct *) calloc (most, sizeof (WordStruct));
+  update->dirty = (uint64_t *) malloc (most * sizeof (uint64_t));
+  uint32_t *context_rows = (uint32_t *) malloc ((delta->contexts.size + 1)
+                                                * sizeof (uint32_t));
+  if (update->rows == NULL || update->dirty == NULL || context_rows == NULL)
+    {
+      printf(ALOCATION_FAILURE);
+      exit (EXIT_FAILURE);
+    }
+  update->dirty_size = 0;
+  for (int id = 0; id < delta->size; ++id)
+    {
+      const WordStruct *word = &delta->words[id];
+      if (word->prob_list_size == 0)
+        {
+          continue;
+        }
+      uint32_t node = update->to_word[id];
+      WordStruct *row = add_dirty_row (model, update, node, node < words
+                                                            ? node
+                                                            : UINT32_MAX);
+      for (int i = 0; i < word->prob_list_size; ++i)
+        {
+          add_successor (row, update->to_word[word->prob_list[i].word_id],
+                         word->prob_list[i].num_of_occurrnces);
+        }
+    }
+  for (uint32_t i = 0; i < delta->contexts.size; ++i)
+    {
+      context_rows[i] = UINT32_MAX;
+    }
+  for (uint32_t i = 0; i < delta->ngrams.size; ++i)
+    {
+      uint32_t context = (delta->ngrams.keys[i] >> 32) & ~CONTEXT_BIT;
+      if (context_rows[context] == UINT32_MAX)
+        {
+          uint32_t index = update->to_context[context];
+          context_rows[context] = update->dirty_size;
+          add_dirty_row (model, update, nodes + index,
+                         index < model->header->context_count
+                         ? words + index : UINT32_MAX);
+        }
+      add_successor (&update->rows[context_rows[context]],
+                     update->to_word[(uint32_t) delta->ngrams.keys[i]],
+                     (int) delta->ngrams.counts[i]);
+    }
+  free (context_rows);
+  qsort (update->dirty, update->dirty_size, sizeof (uint64_t), compare_keys);
+}
+
+/**
+ * @param model the model
+ * @param update the update
+ * @param node a node of the updated model
+ * @return the node in the model, UINT32_MAX if it is new
+ */
+uint32_t previous_node (const Model *model, const Update *update,
+                        uint32_t node)
+{
+  uint32_t words = model->header->word_count;
+  if (node < words)
+    {
+      return node;
+    }
+  if (node < words + update->added_words)
+    {
+      return UINT32_MAX;
+    }
+  node -= update->added_words;
+  return node < words + model->header->context_count ? node : UINT32_MAX;
+}
+
+/**
+ * Copies the words of the model to the updated model and adds the file's:
+ * the counts of the words the model has, and the words it doesn't.
+ * @param updated the updated model
+ * @param model the model
+ * @param update the update
+ */
+void freeze_update_words (Model *updated, const Model *model,
+                          const Update *update)
+{
+  const ModelHeader *header = model->header;
+  char *text = (char *) updated->text;
+  uint64_t *text_offsets = (uint64_t *) updated->text_offsets;
+  uint32_t *occurrences = (uint32_t *) updated->occurrences;
+  uint32_t *starters = (uint32_t *) updated->starters;
+  memcpy (text, model->text, header->text_size);
+  memcpy (text_offsets, model->text_offsets,
+          ((size_t) header->word_count + 1) * sizeof (uint64_t));
+  memcpy (occurrences, model->occurrences,
+          header->word_count * sizeof (uint32_t));
+  memcpy (starters, model->starters, header->starter_count * sizeof (uint32_t));
+  uint64_t text_size = header->text_size;
+  uint32_t starter_count = header->starter_count;
+  // the new words come in the order of their ids
+  for (int i = 0; i < update->delta->size; ++i)
+    {
+      WordStruct *word = &update->delta->words[i];
+      uint32_t id = update->to_word[i];
+      if (id < header->word_count)
+        {
+          occurrences[id] += word->number_of_occurrence;
+          continue;
+        }
+      memcpy (text + text_size, word->word, word->length + 1);
+      text_size += word->length + 1;
+      text_offsets[id + 1] = text_size;
+      occurrences[id] = word->number_of_occurrence;
+      if (dot_at_end (word) == 1)
+        {
+          starters[starter_count++] = id;
+        }
+    }
+}
+
+/**
+ * Copies the rows of nodes [first, last) of the updated model, which the
+ * file doesn't touch, from the model with their alias tables: every run of
+ * them that is in the model is copied at once, and new nodes get empty
+ * rows.
+ * @param updated the updated model
+ * @param model the model
+ * @param update the update
+ * @param first, last the nodes
+ * @param edge index of the next successor of the updated model, advanced
+ */
+void copy_rows (Model *updated, const Model *model, const Update *update,
+                uint32_t first, uint32_t last, uint64_t *edge)
+{
+  uint64_t *rows = (uint64_t *) updated->rows;
+  uint32_t words = model->header->word_count + update->added_words;
+  // the nodes of the updated model are the model's words, the new words,
+  // the model's contexts and the new contexts
+  uint32_t ends[] = {model->header->word_count, words,
+                     words + model->header->context_count, UINT32_MAX};
+  for (int part = 0; first < last; ++part)
+    {
+      uint32_t end = ends[part] < last ? ends[part] : last;
+      if (first >= end)
+        {
+          continue;
+        }
+      uint32_t previous = previous_node (model, update, first);
+      if (previous == UINT32_MAX)
+        {
+          for (uint32_t node = first; node < end; ++node)
+            {
+              rows[node] = *edge;
+            }
+          first = end;
+          continue;
+        }
+      uint64_t low = model->rows[previous];
+      uint64_t length = model->rows[previous + end - first] - low;
+      for (uint32_t node = first; node < end; ++node)
+        {
+          rows[node] = model->rows[previous + node - first] - low + *edge;
+        }
+      memcpy ((uint32_t *) updated->successors + *edge,
+              model->successors + low, length * sizeof (uint32_t));
+      memcpy ((uint32_t *) updated->cumulative + *edge,
+              model->cumulative + low, length * sizeof (uint32_t));
+      memcpy ((AliasEntry *) updated->alias + *edge, model->alias + low,
+              length * sizeof (AliasEntry));
+      *edge += length;
+      first = end;
+    }
+}
+
+/**
+ * Stores the rows of the updated model: the runs of rows the file doesn't
+ * touch are copied from the model, and the rows it does are stored from
+ * their updated successors, with new alias tables.
+ * @param updated the updated model
+ * @param model the model
+ * @param update the update
+ */
+void freeze_update_rows (Model *updated, const Model *model,
+                         const Update *update)
+{
+  uint64_t *rows = (uint64_t *) updated->rows;
+  uint32_t nodes = updated->header->word_count
+                   + updated->header->context_count;
+  uint64_t edge = 0;
+  uint32_t next = 0;
+  int longest = 0;
+  for (uint32_t i = 0; i < update->dirty_size; ++i)
+    {
+      uint32_t node = update->dirty[i] >> 32;
+      const WordStruct *row = &update->rows[(uint32_t) update->dirty[i]];
+      copy_rows (updated, model, update, next, node, &edge);
+      rows[node] = edge;
+      edge = freeze_row (updated, row, edge);
+      longest = row->prob_list_size > longest ? row->prob_list_size : longest;
+      next = node + 1;
+    }
+  copy_rows (updated, model, update, next, nodes, &edge);
+  rows[nodes] = edge;
+  uint64_t *weights = (uint64_t *) malloc ((longest + 1) * sizeof (uint64_t));
+  uint32_t *small = (uint32_t *) malloc ((longest + 1) * sizeof (uint32_t));
+  uint32_t *large = (uint32_t *) malloc ((longest + 1) * sizeof (uint32_t));
+  if (weights == NULL || small == NULL || large == NULL)
+    {
+      printf(ALOCATION_FAILURE);
+      exit (EXIT_FAILURE);
+    }
+  for (uint32_t i = 0; i < update->dirty_size; ++i)
+    {
+      uint32_t node = update->dirty[i] >> 32;
+      build_alias_row (updated, rows[node],
+                       (uint32_t) (rows[node + 1] - rows[node]), weights,
+                       small, large);
+    }
+  free (weights);
+  free (small);
+  free (large);
+}
+
+/**
+ * Builds the updated model out of the model and the update, copying
+ * everything the file doesn't change. The context table is copied and the
+ * new contexts are added to it, unless it has to grow, in which case it is
+ * filled again.
+ * @param model the model
+ * @param update the update, with its rows merged
+ * @return the updated model, on the heap
+ */
+Model *freeze_update (const Model *model, const Update *update)
+{
+  const ModelHeader *previous = model->header;
+  ModelHeader header = *previous;
+  header.word_count += update->added_words;
+  header.context_count += update->added_contexts;
+  while (header.context_slots < 2 * header.context_count)
+    {
+      header.context_slots = header.context_slots == 0
+                             ? NGRAM_INITIAL_CAP : header.context_slots * 2;
+    }
+  for (uint32_t i = 0; i < update->dirty_size; ++i)
+    {
+      uint32_t node = previous_node (model, update, update->dirty[i] >> 32);
+      header.edge_count += update->rows[(uint32_t) update->dirty[i]]
+          .prob_list_size;
+      header.edge_count -= node == UINT32_MAX ? 0 : model->rows[node + 1]
+                                                    - model->rows[node];
+    }
+  for (int i = 0; i < update->delta->size; ++i)
+    {
+      WordStruct *word = &update->delta->words[i];
+      if (update->to_word[i] >= previous->word_count)
+        {
+          header.text_size += word->length + 1;
+          header.starter_count += dot_at_end (word) == 1;
+        }
+    }
+  plan_model (&header);
+  Model *updated = (Model *) calloc (1, sizeof (Model));
+  void *buffer = calloc (1, header.size);
+  if (updated == NULL || buffer == NULL)
+    {
+      printf(ALOCATION_FAILURE);
+      exit (EXIT_FAILURE);
+    }
+  memcpy (buffer, &header, sizeof (ModelHeader));
+  view_model (updated, buffer, 0);
+  freeze_update_words (updated, model, update);
+  freeze_update_rows (updated, model, update);
+  if (header.context_slots == previous->context_slots)
+    {
+      memcpy ((uint64_t *) updated->context_keys, model->context_keys,
+              header.context_slots * sizeof (uint64_t));
+      memcpy ((uint32_t *) updated->context_indices, model->context_indices,
+              header.context_slots * sizeof (uint32_t));
+    }
+  else
+    {
+      for (uint32_t slot = 0; slot < header.context_slots; ++slot)
+        {
+          ((uint64_t *) updated->context_keys)[slot] = EMPTY_KEY;
+        }
+      for (uint32_t slot = 0; slot < previous->context_slots; ++slot)
+        {
+          if (model->context_keys[slot] != EMPTY_KEY)
+            {
+              insert_context (updated, model->context_keys[slot],
+                              model->context_indices[slot]);
+            }
+        }
+    }
+  for (uint32_t i = 0; i < update->delta->contexts.size; ++i)
+    {
+      if (update->to_context[i] >= previous->context_count)
+        {
+          insert_context (updated, map_key (update,
+                                            update->delta->contexts.keys[i]),
+                          update->to_context[i]);
+        }
+    }
+  return updated;
+}
+
+/**
+ * Frees the memory of the update.
+ * @param update the update
+ */
+void free_update (Update *update)
+{
+  for (uint32_t i = 0; i < update->dirty_size; ++i)
+    {
+      free (update->rows[i].prob_list);
+      free (update->rows[i].successor_slots);
+    }
+  free (update->rows);
+  free (update->dirty);
+  free (update->to_context);
+  free (update->to_word);
+  free_dictionary (update->delta);
+}
@@ -0,0 +1,97 @@
+#ifndef TWEETS_UPDATE_H_
+#define TWEETS_UPDATE_H_
+
+#include <stdint.h>
+#include "tweetsModel.h"
+
+/*
+ * Adding a corpus to a model that was already frozen: thawing it back to a
+ * dictionary, or updating only the rows the corpus adds to.
+ */
+
+/**
+ * Rebuilds the dictionary a model was frozen from, so more of the corpus can
+ * be read into it. Words get back their ids, prob_lists and contexts keep
+ * their order, and the counts are the differences of the running sums, so
+ * reading a file into the result is the same as having read it after the
+ * corpus of the model. The ngrams come back grouped by context, which is
+ * the order freezing puts them in anyway.
+ * @param model the model
+ * @return the dictionary, on the heap
+ */
+Dictionary *thaw_model (const Model *model);
+
+/**
+ * @struct Update - what appending a corpus file changes in a model.
+ * @param delta the dictionary of the file alone.
+ * @param to_word the id in the updated model of every word of delta.
+ * @param to_context the index in the updated model of every context of
+ * delta.
+ * @param added_words, added_contexts number of words and contexts the model
+ * didn't have, which get the ids and indices after the model's.
+ * @param rows the rows the file adds successors to, each holding the
+ * model's successors of the row followed by the file's.
+ * @param dirty the node of every row of rows, packed with its index in
+ * rows, sorted by node.
+ * @param dirty_size number of rows in rows.
+ */
+typedef struct Update {
+    Dictionary *delta;
+    uint32_t *to_word;
+    uint32_t *to_context;
+    uint32_t added_words;
+    uint32_t added_contexts;
+    WordStruct *rows;
+    uint64_t *dirty;
+    uint32_t dirty_size;
+} Update;
+
+/**
+ * Maps the words of the file to their ids in the updated model. The
+ * model's words are looked up in the file's dictionary straight from the
+ * model's text, stopping once every word of the file is found. The words
+ * the model doesn't have get the next ids in the order the file has them,
+ * as they would if the file was read into the thawed model.
+ * @param model the model
+ * @param update the update, with its delta filled
+ */
+void map_words (const Model *model, Update *update);
+
+/**
+ * Maps the contexts of the file to their indices in the updated model,
+ * looking them up in the model's context table. A context comes after the
+ * context it extends, so its key can always be mapped, and the contexts
+ * the model doesn't have get the next indices in the order of the file.
+ * @param model the model
+ * @param update the update, with its words mapped
+ */
+void map_contexts (const Model *model, Update *update);
+
+/**
+ * Builds the updated rows of every node the file adds successors to: the
+ * model's successors of the node are thawed, then the file's are added, in
+ * the order the file first has them, so every row ends up as it would in
+ * the thawed model. The other rows stay frozen.
+ * @param model the model
+ * @param update the update, with its words and contexts mapped
+ */
+void merge_rows (const Model *model, Update *update);
+
+/**
+ * Builds the updated model out of the model and the update, copying
+ * everything the file doesn't change. The context table is copied and the
+ * new contexts are added to it, unless it has to grow, in which case it is
+ * filled again.
+ * @param model the model
+ * @param update the update, with its rows merged
+ * @return the updated model, on the heap
+ */
+Model *freeze_update (const Model *model, const Update *update);
+
+/**
+ * Frees the memory of the update.
+ * @param update the update
+ */
+void free_update (Update *update);
+
+#endif //TWEETS_UPDATE_H_
@@ -0,0 +1,146 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <time.h>
+#include "bench_util.h"
+
+#define KEY_MULTIPLIER_1 0x85ebca6bu
+#define KEY_MULTIPLIER_2 0xc2b2ae35u
+
+/**
+ * The number of calls to int_cmp so far.
+ */
+size_t comparisons = 0;
+
+/**
+ * Allocates an array on the heap, exiting if it fails.
+ * @param count, size the number of elements and the size of each
+ * @return the array, of at least one element
+ */
+void *alloc_array (int count, size_t size)
+{
+  void *array = malloc (size * (count > 0 ? count : 1));
+  if (array == NULL)
+    {
+      printf (ALOCATION_FAILURE);
+      exit (EXIT_FAILURE);
+    }
+  return array;
+}
+
+/**
+ * Copies an int to the heap, exiting if the allocation fails.
+ * @param elem the int
+ * @return the copy
+ */
+void *int_cpy (const void *elem)
+{
+  int *a = alloc_array (1, sizeof (int));
+  *a = *((const int *) elem);
+  return a;
+}
+
+/**
+ * Compares ints, counting the calls in comparisons.
+ * @param elem_1, elem_2 the ints
+ * @return 1 if they are equal, 0 otherwise
+ */
+int int_cmp (const void *elem_1, const void *elem_2)
+{
+  comparisons++;
+  return *((const int *) elem_1) == *((const int *) elem_2);
+}
+
+/**
+ * Frees an element on the heap, and sets the pointer to it to NULL.
+ * @param elem pointer to the element
+ */
+void elem_free (void **elem)
+{
+  free (*elem);
+  *elem = NULL;
+}
+
+/**
+ * @return the current monotonic time in seconds
+ */
+double get_time (void)
+{
+  struct timespec now;
+  clock_gettime (CLOCK_MONOTONIC, &now);
+  return (double) now.tv_sec + (double) now.tv_nsec / 1e9;
+}
+
+/**
+ * Scrambles a number with the finalizer of murmur3: the xor-shifts and the
+ * multiplications by odd numbers can be undone, so two numbers never give
+ * the same key.
+ * @param number the number
+ * @return the key
+ */
+uint32_t scramble (uint32_t number)
+{
+  number ^= number >> 16;
+  number *= KEY_MULTIPLIER_1;
+  number ^= number >> 13;
+  number *= KEY_MULTIPLIER_2;
+  number ^= number >> 16;
+  return number;
+}
+
+/**
+ * Makes the keys of the numbers [first, first + count), scrambled with the
+ * seed.
+ * @param first, count the numbers to make the keys of
+ * @param seed the seed, xored into every number before it is scrambled
+ * @return the keys, on the heap
+ */
+int *make_keys (int first, int count, uint32_t seed)
+{
+  int *keys = alloc_array (count, sizeof (int));
+  for (int i = 0; i < count; ++i)
+    {
+      keys[i] = (int) scramble ((uint32_t) (first + i) ^ seed);
+    }
+  return keys;
+}
+
+/**
+ * Makes a pair for every key, from the key to its index, with int values.
+ * @param keys the keys, key_stride bytes apart
+ * @param key_stride the distance between the keys
+ * @param count number of keys
+ * @param key_cpy, key_cmp the functions of the keys, the keys and the values
+ * are freed with elem_free
+ * @return the pairs, on the heap
+ */
+pair **make_pairs (const void *keys, size_t key_stride, int count,
+                   pair_key_cpy key_cpy, pair_key_cmp key_cmp)
+{
+  pair **pairs = alloc_array (count, sizeof (pair *));
+  for (int i = 0; i < count; ++i)
+    {
+      pairs[i] = pair_alloc ((const char *) keys + (size_t) i * key_stride,
+                             &i, key_cpy, int_cpy, key_cmp, int_cmp,
+                             elem_free, elem_free);
+      if (pairs[i] == NULL)
+        {
+          printf (ALOCATION_FAILURE);
+          exit (EXIT_FAILURE);
+        }
+    }
+  return pairs;
+}
+
+/**
+ * Frees the pairs and the array holding them.
+ * @param pairs the pairs
+ * @param count number of pairs
+ */
+void free_pairs (pair **pairs, int count)
+{
+  for (int i = 0; i < count; ++i)
+    {
+      pair_free ((void **) &pairs[i]);
+    }
+  free (pairs);
+}
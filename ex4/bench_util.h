@@ -0,0 +1,90 @@
+#ifndef BENCH_UTIL_H_
+#define BENCH_UTIL_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+#include "pair.h"
+
+/*
+ * The helpers both hash map benchmarks use, so they make their keys and
+ * time their runs the same way.
+ */
+
+#define ALOCATION_FAILURE "Allocation failure: Too much junk on the computer, \
+free some space!"
+
+/**
+ * The number of calls to int_cmp so far.
+ */
+extern size_t comparisons;
+
+/**
+ * Allocates an array on the heap, exiting if it fails.
+ * @param count, size the number of elements and the size of each
+ * @return the array, of at least one element
+ */
+void *alloc_array (int count, size_t size);
+
+/**
+ * Copies an int to the heap, exiting if the allocation fails.
+ * @param elem the int
+ * @return the copy
+ */
+void *int_cpy (const void *elem);
+
+/**
+ * Compares ints, counting the calls in comparisons.
+ * @param elem_1, elem_2 the ints
+ * @return 1 if they are equal, 0 otherwise
+ */
+int int_cmp (const void *elem_1, const void *elem_2);
+
+/**
+ * Frees an element on the heap, and sets the pointer to it to NULL.
+ * @param elem pointer to the element
+ */
+void elem_free (void **elem);
+
+/**
+ * @return the current monotonic time in seconds
+ */
+double get_time (void);
+
+/**
+ * Scrambles a number: the xor-shifts and the multiplications by odd numbers
+ * can be undone, so two numbers never give the same key.
+ * @param number the number
+ * @return the key
+ */
+uint32_t scramble (uint32_t number);
+
+/**
+ * Makes distinct keys in a scattered order, of which no bits follow the
+ * numbers they are made of, so the keys made of other numbers are not
+ * kept off the buckets of these by the hash.
+ * @param first, count the numbers to make the keys of
+ * @param seed the seed
+ * @return the keys, on the heap
+ */
+int *make_keys (int first, int count, uint32_t seed);
+
+/**
+ * Makes the pairs to insert, mapping every key to its index, ahead of the
+ * measuring so neither their time nor their allocations are counted.
+ * @param keys the keys, key_stride bytes apart
+ * @param key_stride the distance between the keys
+ * @param count number of keys
+ * @param key_cpy, key_cmp the functions of the keys
+ * @return the pairs, on the heap
+ */
+pair **make_pairs (const void *keys, size_t key_stride, int count,
+                   pair_key_cpy key_cpy, pair_key_cmp key_cmp);
+
+/**
+ * Frees the pairs make_pairs made.
+ * @param pairs the pairs
+ * @param count number of pairs
+ */
+void free_pairs (pair **pairs, int count);
+
+#endif //BENCH_UTIL_H_
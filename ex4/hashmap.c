@@ -1,7 +1,4 @@
-#include "hashmap.h"
-
-#define INCREASE 1
-#define DECREASE 2
+#include "hashmap_inline.h"
 
 /**
  * Allocates dynamically new hash map element.
@@ -23,7 +20,20 @@ hashmap *hashmap_alloc (hash_func func)
   map->capacity = HASH_MAP_INITIAL_CAP;
   map->size = 0;
   map->hash_func = func;
-  map->buckets = calloc (1, sizeof (vector) * map->capacity);
+  map->control = NULL;
+  map->slots = NULL;
+  map->deleted = 0;
+  map->key_size = 0;
+  map->value_size = 0;
+  map->slot_size = 0;
+  map->key_cmp = NULL;
+  slab_pool_init (&map->pairs, sizeof (pair));
+  slab_pool_init (&map->vectors, sizeof (vector));
+  map->incremental = 0;
+  map->old_buckets = NULL;
+  map->old_capacity = 0;
+  map->migrated = 0;
+  map->buckets = calloc (map->capacity, sizeof (vector *));
   if (map->buckets == NULL)
     {
       free (map);
@@ -33,42 +43,80 @@ hashmap *hashmap_alloc (hash_func func)
 }
 
 /**
- * Frees a hash map and the elements the hash map itself allocated.
- * @param p_hash_map pointer to dynamically allocated pointer to hash_map.
+ * Allocates dynamically new hash map element which resizes incrementally.
+ * @param func a function which "hashes" keys.
+ * @return pointer to dynamically allocated hashmap.
+ * @if_fail return NULL.
  */
-void hashmap_free (hashmap **p_hash_map)
+hashmap *hashmap_alloc_incremental (hash_func func)
 {
-  for (size_t ind = 0; ind < (*p_hash_map)->capacity; ++ind)
+  hashmap *map = hashmap_alloc (func);
+  if (map != NULL)
     {
-      if ((*p_hash_map)->buckets[ind] != NULL)
-        {
-          vector_free (&(*p_hash_map)->buckets[ind]);
-          (*p_hash_map)->buckets[ind] = NULL;
-        }
+      map->incremental = 1;
     }
-  free ((*p_hash_map)->buckets);
-  (*p_hash_map)->buckets = NULL;
-  free (*p_hash_map);
-  *p_hash_map = NULL;
+  return map;
 }
 
 /**
- * frees the hashmap buckets
- * @param buckets the buckets holding vectors
+ * Frees the keys and values of the pairs of a bucket and its data, but not
+ * the pairs and the vector themselves, which go with the slabs of the map.
+ * @param bucket the bucket
+ */
+void free_bucket_contents (vector *bucket)
+{
+  for (size_t ind = 0; ind < bucket->size; ++ind)
+    {
+      pair *temp = bucket->data[ind];
+      temp->key_free (&temp->key);
+      temp->value_free (&temp->value);
+    }
+  free (bucket->data);
+}
+
+/**
+ * Frees the contents of all the buckets of a table, and the table.
+ * @param buckets the buckets
  * @param capacity number of buckets
  */
-void free_buckets (vector **buckets, size_t capacity)
+void free_table_contents (vector **buckets, size_t capacity)
 {
   for (size_t ind = 0; ind < capacity; ++ind)
     {
       if (buckets[ind] != NULL)
         {
-          vector_free (&buckets[ind]);
-          buckets[ind] = NULL;
+          free_bucket_contents (buckets[ind]);
         }
     }
   free (buckets);
 }
+
+/**
+ * Frees a hash map and the elements the hash map itself allocated.
+ * @param p_hash_map pointer to dynamically allocated pointer to hash_map.
+ */
+void hashmap_free (hashmap **p_hash_map)
+{
+  if ((*p_hash_map)->control != NULL)
+    {
+      inline_free (*p_hash_map);
+    }
+  else
+    {
+      free_table_contents ((*p_hash_map)->buckets, (*p_hash_map)->capacity);
+      if ((*p_hash_map)->old_buckets != NULL)
+        {
+          free_table_contents ((*p_hash_map)->old_buckets,
+                               (*p_hash_map)->old_capacity);
+        }
+    }
+  slab_pool_clear (&(*p_hash_map)->pairs);
+  slab_pool_clear (&(*p_hash_map)->vectors);
+  (*p_hash_map)->buckets = NULL;
+  free (*p_hash_map);
+  *p_hash_map = NULL;
+}
+
 /**
  * hashes the key to a number
  * @param hash_map the hash table
@@ -81,67 +129,62 @@ size_t get_hash_index (const hashmap *hash_map, const_keyT key)
 }
 
 /**
- * rolls back the changes made before a failure happened
- * @param new_buckets the new buckets
- * @param hash_map the hase table
- * @param flag a number indicating what changes to do
+ * frees the vectors of the buckets, but not the pairs in them, which were
+ * moved to other buckets
+ * @param buckets the buckets holding vectors
+ * @param capacity number of buckets
  */
-void rollback_changes (vector **new_buckets, hashmap *hash_map, int flag)
+void free_bucket_vectors (vector **buckets, size_t capacity)
 {
-  free_buckets (new_buckets, hash_map->capacity);
-  if (flag == 1)
-    {
-      hash_map->capacity = hash_map->capacity / 2;
-    }
-  if (flag == 2)
+  for (size_t ind = 0; ind < capacity; ++ind)
     {
-      hash_map->capacity = hash_map->capacity * 2;
+      if (buckets[ind] != NULL)
+        {
+          buckets[ind]->size = 0;
+          vector_free (&buckets[ind]);
+        }
     }
+  free (buckets);
 }
 
 /**
- * copies the old table to the new table
+ * moves a pair, not a copy of it, to the bucket of its key in new buckets
  * @param hash_map the hash table
- * @param ind the bucket
- * @param vec_ind the vector
+ * @param temp the pair
  * @param new_buckets the new buckets
- * @param flag tells the function which function called her and what to do
+ * @param new_capacity number of new buckets
  * @return 0 if fail else success
  */
-int rehash_helper (hashmap *hash_map, size_t ind, size_t vec_ind,
-                                              vector **new_buckets, int flag)
+int move_pair (hashmap *hash_map, pair *temp, vector **new_buckets,
+               size_t new_capacity)
 {
-  pair *temp = vector_at (hash_map->buckets[ind], vec_ind);
-  size_t key = get_hash_index (hash_map, temp->key);
+  size_t key = hash_map->hash_func (temp->key) & (new_capacity - 1);
   if (new_buckets[key] == NULL)
     {
-      new_buckets[key] = vector_alloc (pair_copy, pair_cmp, pair_free);
+      new_buckets[key] = vector_alloc_from (&hash_map->vectors, pair_copy,
+                                            pair_cmp, pair_free);
       if (new_buckets[key] == NULL)
         {
-          rollback_changes (new_buckets, hash_map, flag);
           return 0;
         }
     }
-  if (vector_push_back (new_buckets[key], temp) == 0)
-    {
-      rollback_changes (new_buckets, hash_map, flag);
-      return 0;
-    }
-  return 1;
+  return vector_push_back_move (new_buckets[key], temp);
 }
 
 /**
- * rehashes the hash table upon enlargement
- * @param hash_map the hase table
+ * rehashes the hash table to a new number of buckets by moving the pairs
+ * themselves, so nothing is copied. The old buckets keep pointing to the
+ * pairs until all of them are moved, so upon a failure only the new buckets
+ * are freed and the table is left as it was.
+ * @param hash_map the hash table
+ * @param new_capacity the new number of buckets, a power of 2
  * @return a new table if successful else NULL
  */
-vector **rehash_increase (hashmap *hash_map)
+vector **rehash (hashmap *hash_map, size_t new_capacity)
 {
-  hash_map->capacity = hash_map->capacity * 2;
-  vector **new_buckets = calloc (1, sizeof (vector) * hash_map->capacity);
+  vector **new_buckets = calloc (new_capacity, sizeof (vector *));
   if (new_buckets == NULL)
     {
-      hash_map->capacity = hash_map->capacity / 2;
       return NULL;
     }
   for (size_t ind = 0; ind < hash_map->capacity; ind++)
@@ -151,55 +194,140 @@ vector **rehash_increase (hashmap *hash_map)
           for (size_t vec_ind = 0;
                vec_ind < hash_map->buckets[ind]->size; vec_ind++)
             {
-              if (rehash_helper (hash_map, ind, vec_ind, new_buckets,
-                                                            INCREASE) == 0)
+              if (move_pair (hash_map, vector_at (hash_map->buckets[ind],
+                                                  vec_ind),
+                             new_buckets, new_capacity) == 0)
                 {
+                  free_bucket_vectors (new_buckets, new_capacity);
                   return NULL;
                 }
             }
         }
     }
-  free_buckets (hash_map->buckets, hash_map->capacity / 2);
+  free_bucket_vectors (hash_map->buckets, hash_map->capacity);
+  hash_map->capacity = new_capacity;
   return new_buckets;
 }
 
 /**
- * rehashes the hash table upon reduction
- * @param hash_map the hase table
- * @return a new table if successful else NULL
+ * moves the pairs of an old bucket to the new buckets, one at a time, so
+ * upon a failure every pair is still in one table or the other
+ * @param hash_map the hash table, while resizing incrementally
+ * @param ind the old bucket
+ * @return 0 if fail else success
  */
-vector **rehash_decrease (hashmap *hash_map)
+int migrate_bucket (hashmap *hash_map, size_t ind)
 {
-  hash_map->capacity = hash_map->capacity / 2;
-  vector **new_buckets = calloc (1, sizeof (vector) * hash_map->capacity);
+  vector *bucket = hash_map->old_buckets[ind];
+  if (bucket == NULL)
+    {
+      return 1;
+    }
+  while (bucket->size > 0)
+    {
+      if (move_pair (hash_map, bucket->data[bucket->size - 1],
+                     hash_map->buckets, hash_map->capacity) == 0)
+        {
+          return 0;
+        }
+      bucket->size--;
+    }
+  vector_free (&hash_map->old_buckets[ind]);
+  return 1;
+}
+
+/**
+ * moves the pairs of the next old buckets to the new ones, and frees the
+ * old buckets once none are left
+ * @param hash_map the hash table, while resizing incrementally
+ * @param count the number of old buckets to move
+ * @return 0 if fail else success
+ */
+int migrate_step (hashmap *hash_map, size_t count)
+{
+  for (; count > 0 && hash_map->migrated < hash_map->old_capacity; count--)
+    {
+      if (migrate_bucket (hash_map, hash_map->migrated) == 0)
+        {
+          return 0;
+        }
+      hash_map->migrated++;
+    }
+  if (hash_map->migrated == hash_map->old_capacity)
+    {
+      free (hash_map->old_buckets);
+      hash_map->old_buckets = NULL;
+      hash_map->old_capacity = 0;
+      hash_map->migrated = 0;
+    }
+  return 1;
+}
+
+/**
+ * resizes the hash table to a new number of buckets: all at once, or for an
+ * incremental one by making the current buckets the old ones, after moving
+ * whatever is left of a previous resize
+ * @param hash_map the hash table
+ * @param new_capacity the new number of buckets, a power of 2
+ * @return 0 if fail else success
+ */
+int resize (hashmap *hash_map, size_t new_capacity)
+{
+  if (hash_map->incremental == 0)
+    {
+      vector **new_buckets = rehash (hash_map, new_capacity);
+      if (new_buckets == NULL)
+        {
+          return 0;
+        }
+      hash_map->buckets = new_buckets;
+      return 1;
+    }
+  if (hash_map->old_buckets != NULL
+      && migrate_step (hash_map, hash_map->old_capacity) == 0)
+    {
+      return 0;
+    }
+  vector **new_buckets = calloc (new_capacity, sizeof (vector *));
   if (new_buckets == NULL)
     {
-      hash_map->capacity = hash_map->capacity * 2;
-      return NULL;
+      return 0;
     }
-  for (size_t ind = 0; ind < hash_map->capacity * 2; ind++)
+  hash_map->old_buckets = hash_map->buckets;
+  hash_map->old_capacity = hash_map->capacity;
+  hash_map->buckets = new_buckets;
+  hash_map->capacity = new_capacity;
+  return 1;
+}
+
+/**
+ * finds a key in a bucket
+ * @param bucket the bucket, may be NULL
+ * @param key the key
+ * @return index of the pair of the key in the bucket, -1 if not there
+ */
+int find_in_bucket (const vector *bucket, const_keyT key)
+{
+  if (bucket == NULL)
     {
-      if (hash_map->buckets[ind] != NULL)
+      return -1;
+    }
+  for (size_t ind = 0; ind < bucket->size; ++ind)
+    {
+      pair *temp = vector_at (bucket, ind);
+      if (temp->key_cmp (temp->key, key) == 1)
         {
-          for (size_t vec_ind = 0;
-               vec_ind < hash_map->buckets[ind]->size; vec_ind++)
-            {
-              if (rehash_helper (hash_map, ind, vec_ind, new_buckets,
-                                                                DECREASE) == 0)
-                {
-                  return NULL;
-                }
-            }
+          return (int) ind;
         }
     }
-  free_buckets (hash_map->buckets, hash_map->capacity * 2);
-  return new_buckets;
+  return -1;
 }
 
 /**
  * Inserts a new in_pair to the hash map.
  * The function inserts *new*, *copied*, *dynamically allocated* in_pair,
- * NOT the in_pair it receives as a parameter.
+ * NOT the in_pair it receives as a parameter. The copy is allocated from
+ * the pool of pairs of the map.
  * @param hash_map the hash map to be inserted with new element.
  * @param in_pair a in_pair the hash map would contain.
  * @return returns 1 for successful insertion, 0 otherwise.
@@ -210,33 +338,50 @@ int hashmap_insert (hashmap *hash_map, const pair *in_pair)
     {
       return 0;
     }
+  if (hash_map->control != NULL)
+    {
+      return inline_insert (hash_map, in_pair);
+    }
+  if (hash_map->old_buckets != NULL)
+    {
+      migrate_step (hash_map, HASH_MAP_MIGRATION_STEP);
+    }
   if (hashmap_at (hash_map, in_pair->key) != NULL)
     {
       return 0;
     }
   hash_map->size++;
-  if (hashmap_get_load_factor (hash_map) > HASH_MAP_MAX_LOAD_FACTOR)
+  if (hashmap_get_load_factor (hash_map) > HASH_MAP_MAX_LOAD_FACTOR
+      && resize (hash_map, hash_map->capacity * HASH_MAP_GROWTH_FACTOR) == 0)
     {
-      vector **new_buckets = rehash_increase (hash_map);
-      if (new_buckets == NULL)
-        {
-          hash_map->size--;
-          return 0;
-        }
-      hash_map->buckets = new_buckets;
+      hash_map->size--;
+      return 0;
     }
   size_t key = get_hash_index (hash_map, in_pair->key);
   if (hash_map->buckets[key] == NULL)
     {
-      hash_map->buckets[key] = vector_alloc (pair_copy, pair_cmp, pair_free);
+      hash_map->buckets[key] = vector_alloc_from (&hash_map->vectors,
+                                                  pair_copy, pair_cmp,
+                                                  pair_free);
       if (hash_map->buckets[key] == NULL)
         {
           hash_map->size--;
           return 0;
         }
     }
-  if (vector_push_back (hash_map->buckets[key], in_pair) == 0)
+  pair *copy = pair_alloc_from (&hash_map->pairs, in_pair->key,
+                                in_pair->value, in_pair->key_cpy,
+                                in_pair->value_cpy, in_pair->key_cmp,
+                                in_pair->value_cmp, in_pair->key_free,
+                                in_pair->value_free);
+  if (copy == NULL)
+    {
+      hash_map->size--;
+      return 0;
+    }
+  if (vector_push_back_move (hash_map->buckets[key], copy) == 0)
     {
+      pair_free ((void **) &copy);
       hash_map->size--;
       return 0;
     }
@@ -257,27 +402,48 @@ valueT hashmap_at (const hashmap *hash_map, const_keyT key)
     {
       return NULL;
     }
+  if (hash_map->control != NULL)
+    {
+      return inline_at (hash_map, key);
+    }
   vector *temp = hash_map->buckets[get_hash_index (hash_map, key)];
-  if (temp == NULL)
+  int ind = find_in_bucket (temp, key);
+  if (ind < 0 && hash_map->old_buckets != NULL)
     {
-      return NULL;
+      temp = hash_map->old_buckets[hash_map->hash_func (key)
+                                   & (hash_map->old_capacity - 1)];
+      ind = find_in_bucket (temp, key);
     }
-  for (size_t ind = 0; ind < temp->size; ++ind)
+  if (ind < 0)
     {
-      pair *temp2 = vector_at (temp, ind);
-      if (temp2->key_cmp (temp2->key, key) == 1)
-        {
-          return temp2->value;
-        }
+      return NULL;
     }
-  return NULL;
+  return ((pair *) vector_at (temp, ind))->value;
 }
 
-void free_vector (hashmap *hash_map, size_t key_ind)
+/**
+ * erases the pair of a key from a table of buckets, freeing its bucket if
+ * left empty
+ * @param hash_map the hash table
+ * @param buckets the buckets, the current or the old ones
+ * @param capacity number of buckets
+ * @param key the key
+ * @return 1 if erased, 0 if the key is not there or failed
+ */
+int erase_from (hashmap *hash_map, vector **buckets, size_t capacity,
+                const_keyT key)
 {
-  vector_free (&hash_map->buckets[key_ind]);
-  hash_map->buckets[key_ind] = NULL;
-  hash_map->size--;
+  size_t key_ind = hash_map->hash_func (key) & (capacity - 1);
+  int ind = find_in_bucket (buckets[key_ind], key);
+  if (ind < 0 || vector_erase (buckets[key_ind], ind) == 0)
+    {
+      return 0;
+    }
+  if (buckets[key_ind]->size == 0)
+    {
+      vector_free (&buckets[key_ind]);
+    }
+  return 1;
 }
 
 /**
@@ -289,12 +455,7 @@ int pos_rehash(hashmap *hash_map)
 {
   if (hashmap_get_load_factor (hash_map) < HASH_MAP_MIN_LOAD_FACTOR)
     {
-      vector **new_buckets = rehash_decrease (hash_map);
-      if (new_buckets == NULL)
-        {
-          return 0;
-        }
-      hash_map->buckets = new_buckets;
+      return resize (hash_map, hash_map->capacity / HASH_MAP_GROWTH_FACTOR);
     }
   return 1;
 }
@@ -312,25 +473,23 @@ int hashmap_erase (hashmap *hash_map, const_keyT key)
     {
       return 0;
     }
-  size_t key_ind = get_hash_index (hash_map, key);
-  vector *temp = hash_map->buckets[key_ind];
-  if (temp == NULL)
+  if (hash_map->control != NULL)
     {
-      return 0;
+      return inline_erase (hash_map, key);
     }
-  for (size_t ind = 0; ind < temp->size; ++ind)
+  if (hash_map->old_buckets != NULL)
     {
-      pair *temp2 = vector_at (temp, ind);
-      if (temp2->key_cmp (temp2->key, key) == 1)
-        {
-          if (vector_erase (temp, ind) == 1 && temp->size == 0)
-            {
-              free_vector (hash_map, key_ind);
-              return pos_rehash (hash_map);
-            }
-        }
+      migrate_step (hash_map, HASH_MAP_MIGRATION_STEP);
     }
-  return 0;
+  if (erase_from (hash_map, hash_map->buckets, hash_map->capacity, key) == 0
+      && (hash_map->old_buckets == NULL
+          || erase_from (hash_map, hash_map->old_buckets,
+                         hash_map->old_capacity, key) == 0))
+    {
+      return 0;
+    }
+  hash_map->size--;
+  return pos_rehash (hash_map);
 }
 
 /**
@@ -347,6 +506,37 @@ double hashmap_get_load_factor (const hashmap *hash_map)
   return (double) hash_map->size / (double) hash_map->capacity;
 }
 
+/**
+ * applies valT_func to the values of the keys keyT_func accepts in a table
+ * of buckets
+ * @param buckets the buckets
+ * @param capacity number of buckets
+ * @param keyT_func a function that checks a condition on keyT
+ * @param valT_func a function that modifies valueT, in-place
+ * @return number of changed values
+ */
+int apply_to_buckets (vector *const *buckets, size_t capacity,
+                      keyT_func keyT_func, valueT_func valT_func)
+{
+  int operated_on = 0;
+  for (size_t ind = 0; ind < capacity; ind++)
+    {
+      if (buckets[ind] != NULL)
+        {
+          for (size_t vec_ind = 0; vec_ind < buckets[ind]->size; ++vec_ind)
+            {
+              if (keyT_func (((pair *) buckets[ind]->data[vec_ind])->key)
+                  == 1)
+                {
+                  valT_func (((pair *) buckets[ind]->data[vec_ind])->value);
+                  operated_on++;
+                }
+            }
+        }
+    }
+  return operated_on;
+}
+
 /**
  * This function receives a hashmap and 2 functions, the first checks a
  * condition on the keys,
@@ -371,23 +561,17 @@ int hashmap_apply_if (const hashmap *hash_map, keyT_func keyT_func,
     {
       return -1;
     }
-  int operated_on = 0;
-  for (size_t ind = 0; ind < hash_map->capacity; ind++)
+  if (hash_map->control != NULL)
     {
-      if (hash_map->buckets[ind] != NULL)
-        {
-          for (size_t vec_ind = 0;
-               vec_ind < hash_map->buckets[ind]->size; ++vec_ind)
-            {
-              if (keyT_func (((pair *) hash_map->buckets[ind]->data[vec_ind])
-                                 ->key) == 1)
-                {
-                  valT_func (((pair *) hash_map->buckets[ind]->data[vec_ind])
-                                 ->value);
-                  operated_on++;
-                }
-            }
-        }
+      return inline_apply_if (hash_map, keyT_func, valT_func);
+    }
+  int operated_on = apply_to_buckets (hash_map->buckets, hash_map->capacity,
+                                      keyT_func, valT_func);
+  if (hash_map->old_buckets != NULL)
+    {
+      operated_on += apply_to_buckets (hash_map->old_buckets,
+                                       hash_map->old_capacity, keyT_func,
+                                       valT_func);
     }
   return operated_on;
 }
\ No newline at end of file
@@ -41,6 +41,14 @@
  */
 #define HASH_MAP_MAX_LOAD_FACTOR 0.75
 
+/**
+ * @def HASH_MAP_MIGRATION_STEP
+ * The number of old buckets an incremental hash map (see
+ * hashmap_alloc_incremental) moves to the new ones on every insertion and
+ * erasing while it resizes.
+ */
+#define HASH_MAP_MIGRATION_STEP 8UL
+
 /**
  * @typedef hash_func
  * This type of function receives a keyT and returns
@@ -66,16 +74,51 @@ typedef void (*valueT_func) (valueT);
 
 /**
  * @struct hashmap
- * @param buckets dynamic array of vectors which stores the values.
+ * A hash map has one of two backends: the chained one keeps a vector of
+ * copied pairs per bucket, the inline one (see hashmap_alloc_inline) keeps
+ * the keys and values themselves in one array of slots, found by open
+ * addressing over a parallel array of control bytes.
+ * @param buckets dynamic array of vectors which stores the values, NULL for
+ * the inline backend.
  * @param size the number of elements (pairs) stored in the hash map.
- * @param capacity the number of buckets in the hash map.
+ * @param capacity the number of buckets (or slots) in the hash map.
  * @param hash_func a function which "hashes" keys.
+ * @param control one byte per slot: empty, deleted, or 7 bits of the hash of
+ * the key in it. NULL for the chained backend.
+ * @param slots the keys and values, slot_size bytes per slot.
+ * @param deleted number of deleted slots, which lookups still probe past.
+ * @param key_size, value_size the fixed sizes of the keys and values.
+ * @param slot_size bytes per slot, the value starting key_size bytes in,
+ * rounded up to the alignment.
+ * @param key_cmp compares keys, returns 1 if same, else - 0.
+ * @param pairs, vectors the pools the pairs and the buckets of the chained
+ * backend are allocated from, so freeing the map frees them a slab at a
+ * time.
+ * @param incremental 1 if the chained backend resizes a few buckets at a
+ * time, 0 if all at once.
+ * @param old_buckets the buckets an incremental resize moves the pairs
+ * from, NULL when not resizing. The pairs are in one table or the other.
+ * @param old_capacity the number of old buckets.
+ * @param migrated the number of old buckets whose pairs were all moved.
  */
 typedef struct hashmap {
     vector **buckets;
     size_t size;
     size_t capacity; // num of buckets
     hash_func hash_func;
+    unsigned char *control;
+    unsigned char *slots;
+    size_t deleted;
+    size_t key_size;
+    size_t value_size;
+    size_t slot_size;
+    pair_key_cmp key_cmp;
+    slab_pool pairs;
+    slab_pool vectors;
+    int incremental;
+    vector **old_buckets;
+    size_t old_capacity;
+    size_t migrated;
 } hashmap;
 
 /**
@@ -86,6 +129,34 @@ typedef struct hashmap {
  */
 hashmap *hashmap_alloc (hash_func func);
 
+/**
+ * Allocates dynamically new hash map element which resizes incrementally:
+ * when the load factor calls for a resize it allocates the new buckets and
+ * keeps the old ones, and every insertion and erasing after moves the pairs
+ * of HASH_MAP_MIGRATION_STEP old buckets to the new ones, until none are
+ * left. Lookups and erasing look in both. So no single operation pays for
+ * moving all the pairs.
+ * @param func a function which "hashes" keys.
+ * @return pointer to dynamically allocated hashmap.
+ * @if_fail return NULL.
+ */
+hashmap *hashmap_alloc_incremental (hash_func func);
+
+/**
+ * Allocates dynamically new hash map element with the inline backend, for
+ * keys and values of fixed sizes that can be copied byte by byte.
+ * hashmap_insert copies key_size bytes of the pair's key and value_size
+ * bytes of its value into the map, and hashmap_at returns a pointer to the
+ * value inside it, valid until the next insertion or erasing.
+ * @param func a function which "hashes" keys.
+ * @param key_cmp a function which compares keys.
+ * @param key_size, value_size sizes of the keys and values, in bytes.
+ * @return pointer to dynamically allocated hashmap.
+ * @if_fail return NULL.
+ */
+hashmap *hashmap_alloc_inline (hash_func func, pair_key_cmp key_cmp,
+                               size_t key_size, size_t value_size);
+
 /**
  * Frees a hash map and the elements the hash map itself allocated.
  * @param p_hash_map pointer to dynamically allocated pointer to hash_map.
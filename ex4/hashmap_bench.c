@@ -0,0 +1,351 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "hashmap.h"
+#include "hash_funcs.h"
+#include "bench_util.h"
+
+#define USAGE_ERROR "Usage: Input should be <number of keys> optional - \
+<seed><--latency>\n"
+#define CHECK_ERROR "Error: The %s hash map gave a wrong answer!\n"
+#define BENCH_REPORT "%-11s %d keys: insert %.1f ns, hit %.1f ns, miss %.1f \
+ns, erase %.1f ns, free %.1f ns, key comparisons per hit %.2f, per miss \
+%.2f"
+#define ALLOCATIONS_REPORT ", %.2f allocations per key"
+#define LATENCY_FLAG "--latency"
+#define LATENCY_REPORT "%-11s %d keys: %s p50 %.0f ns, p99 %.0f ns, p99.9 \
+%.0f ns, max %.0f ns\n"
+#define HISTOGRAM_ROW "    < %9.0f ns: %d\n"
+#define HISTOGRAM_FIRST_BIN 64.0
+#define MIN_ARGS 2
+#define MAX_ARGS 3
+#define BASE 10
+#define DEFAULT_SEED 1
+
+/**
+ * @struct Backend - a way to allocate a hash map of int to int.
+ */
+typedef struct Backend {
+    const char *name;
+    hashmap *(*alloc) (void);
+} Backend;
+
+/**
+ * @struct Timings - nanoseconds per operation of every phase, the number
+ * of times the keys were compared per lookup, and the number of allocations
+ * per key.
+ */
+typedef struct Timings {
+    double insert;
+    double hit;
+    double miss;
+    double erase;
+    double teardown;
+    double hit_comparisons;
+    double miss_comparisons;
+    double allocations;
+} Timings;
+
+#ifdef COUNT_ALLOCATIONS
+/**
+ * The number of calls to malloc, calloc and realloc so far. The build links
+ * the benchmark with the linker wrapping them, so the calls in the hash map
+ * are counted too.
+ */
+size_t allocations = 0;
+
+void *__real_malloc (size_t size);
+void *__real_calloc (size_t count, size_t size);
+void *__real_realloc (void *block, size_t size);
+
+void *__wrap_malloc (size_t size)
+{
+  allocations++;
+  return __real_malloc (size);
+}
+
+void *__wrap_calloc (size_t count, size_t size)
+{
+  allocations++;
+  return __real_calloc (count, size);
+}
+
+void *__wrap_realloc (void *block, size_t size)
+{
+  allocations++;
+  return __real_realloc (block, size);
+}
+#endif
+
+hashmap *alloc_chained (void)
+{
+  return hashmap_alloc (hash_int);
+}
+
+hashmap *alloc_incremental (void)
+{
+  return hashmap_alloc_incremental (hash_int);
+}
+
+hashmap *alloc_inline (void)
+{
+  return hashmap_alloc_inline (hash_int, int_cmp, sizeof (int),
+                               sizeof (int));
+}
+
+/**
+ * Inserts the keys, looks all of them up, looks up as many keys that are
+ * not in the map, erases half of the keys and frees the map with the other
+ * half, checking every answer.
+ * @param backend the hash map to measure
+ * @param pairs the pairs to insert, of the keys
+ * @param keys the keys in the map
+ * @param missing keys never inserted
+ * @param count number of keys of each
+ * @param timings where to store the nanoseconds per operation, and the
+ * allocations per key if they are counted
+ * @return 0 if all the answers were right, 1 otherwise
+ */
+int run_backend (const Backend *backend, pair *const *pairs, const int *keys,
+                 const int *missing, int count, Timings *timings)
+{
+  hashmap *map = backend->alloc ();
+  if (map == NULL)
+    {
+      printf (ALOCATION_FAILURE);
+      exit (EXIT_FAILURE);
+    }
+  int wrong = 0;
+#ifdef COUNT_ALLOCATIONS
+  size_t first_allocation = allocations;
+#endif
+  double start = get_time ();
+  for (int i = 0; i < count; ++i)
+    {
+      wrong |= hashmap_insert (map, pairs[i]) != 1;
+    }
+  double inserted = get_time ();
+  comparisons = 0;
+  for (int i = 0; i < count; ++i)
+    {
+      const int *value = hashmap_at (map, &keys[i]);
+      wrong |= value == NULL || *value != i;
+    }
+  double hit = get_time ();
+  size_t hit_comparisons = comparisons;
+  comparisons = 0;
+  for (int i = 0; i < count; ++i)
+    {
+      wrong |= hashmap_at (map, &missing[i]) != NULL;
+    }
+  double missed = get_time ();
+  size_t miss_comparisons = comparisons;
+  int erasing = count / 2;
+  for (int i = 0; i < erasing; ++i)
+    {
+      wrong |= hashmap_erase (map, &keys[i]) != 1;
+    }
+  double erased = get_time ();
+  wrong |= map->size != (size_t) (count - erasing);
+  hashmap_free (&map);
+  double freed = get_time ();
+  double scale = count > 0 ? 1e9 / count : 0;
+  double per_key = count > 0 ? 1.0 / count : 0;
+  *timings = (Timings) {(inserted - start) * scale, (hit - inserted) * scale,
+                        (missed - hit) * scale,
+                        erasing > 0 ? (erased - missed) * 1e9 / erasing : 0,
+                        count > erasing ? (freed - erased) * 1e9
+                                          / (count - erasing) : 0,
+                        hit_comparisons * per_key,
+                        miss_comparisons * per_key, 0};
+#ifdef COUNT_ALLOCATIONS
+  timings->allocations = (allocations - first_allocation) * per_key;
+#endif
+  return wrong;
+}
+
+/**
+ * Inserts the keys and then erases them, timing every operation on its own.
+ * @param backend the hash map to measure
+ * @param pairs the pairs to insert, of the keys
+ * @param keys the keys
+ * @param count number of keys
+ * @param inserts, erases where to store the seconds every insertion and
+ * every erasing took
+ * @return 0 if all the answers were right, 1 otherwise
+ */
+int run_latencies (const Backend *backend, pair *const *pairs,
+                   const int *keys, int count, double *inserts,
+                   double *erases)
+{
+  hashmap *map = backend->alloc ();
+  if (map == NULL)
+    {
+      printf (ALOCATION_FAILURE);
+      exit (EXIT_FAILURE);
+    }
+  int wrong = 0;
+  for (int i = 0; i < count; ++i)
+    {
+      double start = get_time ();
+      wrong |= hashmap_insert (map, pairs[i]) != 1;
+      inserts[i] = get_time () - start;
+    }
+  for (int i = 0; i < count; ++i)
+    {
+      double start = get_time ();
+      wrong |= hashmap_erase (map, &keys[i]) != 1;
+      erases[i] = get_time () - start;
+    }
+  wrong |= map->size != 0;
+  hashmap_free (&map);
+  return wrong;
+}
+
+/**
+ * compares latencies for sorting them from the smallest up
+ * @param a, b pointers to the latencies
+ * @return negative if a comes first, positive if b does, 0 if equal
+ */
+int compare_latencies (const void *a, const void *b)
+{
+  double first = *(const double *) a;
+  double second = *(const double *) b;
+  return (first > second) - (first < second);
+}
+
+/**
+ * @param sorted latencies sorted from the smallest up
+ * @param count number of latencies, at least 1
+ * @param percentile the percentile, in [0, 100]
+ * @return the latency below which the given percentage of them are
+ */
+double percentile_of (const double *sorted, int count, double percentile)
+{
+  int index = (int) (percentile / 100.0 * count + 0.5) - 1;
+  if (index < 0)
+    {
+      index = 0;
+    }
+  return sorted[index < count ? index : count - 1];
+}
+
+/**
+ * Prints the percentiles of the latencies of an operation and a histogram
+ * of them, in bins twice as wide as the ones before.
+ * @param name the name of the hash map
+ * @param operation the name of the operation
+ * @param latencies the seconds every operation took, sorted in place
+ * @param count number of latencies
+ */
+void report_latencies (const char *name, const char *operation,
+                       double *latencies, int count)
+{
+  if (count == 0)
+    {
+      return;
+    }
+  qsort (latencies, count, sizeof (double), compare_latencies);
+  printf (LATENCY_REPORT, name, count, operation,
+          percentile_of (latencies, count, 50) * 1e9,
+          percentile_of (latencies, count, 99) * 1e9,
+          percentile_of (latencies, count, 99.9) * 1e9,
+          latencies[count - 1] * 1e9);
+  double bound = HISTOGRAM_FIRST_BIN;
+  int ind = 0;
+  while (ind < count)
+    {
+      int in_bin = 0;
+      while (ind < count && latencies[ind] * 1e9 < bound)
+        {
+          in_bin++;
+          ind++;
+        }
+      if (in_bin > 0)
+        {
+          printf (HISTOGRAM_ROW, bound, in_bin);
+        }
+      bound *= 2;
+    }
+}
+
+/**
+ * Measures every hash map on the same int to int workload and prints the
+ * nanoseconds per operation of each, how many times each compared keys per
+ * lookup and, when the build counts them, how many times each allocated
+ * memory per key. With --latency, prints instead the percentiles and
+ * histograms of the times single insertions and erasings took.
+ * @param argc
+ * @param argv 1) Number of keys
+ *             2) Optional - Seed, 1 by default
+ *             3) Optional - --latency
+ */
+int main (int argc, char *argv[])
+{
+  int latency = argc > MIN_ARGS
+                && strcmp (argv[argc - 1], LATENCY_FLAG) == 0;
+  argc -= latency;
+  if (argc < MIN_ARGS || argc > MAX_ARGS)
+    {
+      printf (USAGE_ERROR);
+      return EXIT_FAILURE;
+    }
+  char *ptr = NULL;
+  int count = strtol (argv[1], &ptr, BASE);
+  uint32_t seed = argc > MIN_ARGS ? strtoul (argv[2], &ptr, BASE)
+                                  : DEFAULT_SEED;
+  if (count < 0)
+    {
+      printf (USAGE_ERROR);
+      return EXIT_FAILURE;
+    }
+  int *keys = make_keys (0, count, seed);
+  int *missing = make_keys (count, count, seed);
+  pair **pairs = make_pairs (keys, sizeof (int), count, int_cpy, int_cmp);
+  const Backend backends[] = {{"chained", alloc_chained},
+                              {"incremental", alloc_incremental},
+                              {"inline", alloc_inline}};
+  int failed = 0;
+  for (size_t i = 0; i < sizeof (backends) / sizeof (Backend) && latency;
+       ++i)
+    {
+      double *inserts = alloc_array (count, sizeof (double));
+      double *erases = alloc_array (count, sizeof (double));
+      if (run_latencies (&backends[i], pairs, keys, count, inserts, erases)
+          != 0)
+        {
+          printf (CHECK_ERROR, backends[i].name);
+          failed = 1;
+        }
+      else
+        {
+          report_latencies (backends[i].name, "insert", inserts, count);
+          report_latencies (backends[i].name, "erase", erases, count);
+        }
+      free (inserts);
+      free (erases);
+    }
+  for (size_t i = 0; i < sizeof (backends) / sizeof (Backend) && !latency;
+       ++i)
+    {
+      Timings timings;
+      if (run_backend (&backends[i], pairs, keys, missing, count, &timings)
+          != 0)
+        {
+          printf (CHECK_ERROR, backends[i].name);
+          failed = 1;
+          continue;
+        }
+      printf (BENCH_REPORT, backends[i].name, count, timings.insert,
+              timings.hit, timings.miss, timings.erase, timings.teardown,
+              timings.hit_comparisons, timings.miss_comparisons);
+#ifdef COUNT_ALLOCATIONS
+      printf (ALLOCATIONS_REPORT, timings.allocations);
+#endif
+      printf ("\n");
+    }
+  free_pairs (pairs, count);
+  free (keys);
+  free (missing);
+  return failed ? EXIT_FAILURE : 0;
+}
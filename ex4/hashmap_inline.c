@@ -0,0 +1,328 @@
+#include <string.h>
+#include "hashmap_inline.h"
+
+#define NOT_FOUND SIZE_MAX
+
+/**
+ * Rounds a size up to a multiple of SLOT_ALIGNMENT.
+ * @param size a size in bytes
+ * @return the rounded size
+ */
+size_t align_up (size_t size)
+{
+  return (size + SLOT_ALIGNMENT - 1) & ~(SLOT_ALIGNMENT - 1);
+}
+
+/**
+ * Hashes the key and mixes the bits of the result.
+ * @param hash_map the hash table
+ * @param key the key
+ * @return the mixed hash
+ */
+uint64_t mix_hash (const hashmap *hash_map, const_keyT key)
+{
+  return mix_bits ((uint64_t) hash_map->hash_func (key));
+}
+
+/**
+ * @param hash_map the hash table
+ * @param ind index of a slot
+ * @return pointer to the key in the slot, the value follows it
+ */
+unsigned char *slot_at (const hashmap *hash_map, size_t ind)
+{
+  return hash_map->slots + ind * hash_map->slot_size;
+}
+
+/**
+ * @param hash_map the hash table
+ * @param ind index of a slot
+ * @return pointer to the value in the slot
+ */
+unsigned char *value_at (const hashmap *hash_map, size_t ind)
+{
+  return slot_at (hash_map, ind) + align_up (hash_map->key_size);
+}
+
+/**
+ * Allocates empty slots and control bytes, without touching the map.
+ * @param capacity number of slots, a power of 2
+ * @param slot_size bytes per slot
+ * @param control where to store the control bytes
+ * @param slots where to store the slots
+ * @return 1 if successful else 0
+ */
+int alloc_slots (size_t capacity, size_t slot_size, unsigned char **control,
+                 unsigned char **slots)
+{
+  *control = malloc (capacity);
+  *slots = malloc (capacity * slot_size);
+  if (*control == NULL || *slots == NULL)
+    {
+      free (*control);
+      free (*slots);
+      return 0;
+    }
+  memset (*control, CONTROL_EMPTY, capacity);
+  return 1;
+}
+
+/**
+ * Finds the slot of a key: probes a group of GROUP_WIDTH slots at a time,
+ * comparing the control bytes of the group with the hash all at once, and
+ * the key only in the slots whose control byte matches, until a group with
+ * an empty slot ends the search.
+ * @param hash_map the hash table
+ * @param key the key
+ * @param hash the mixed hash of the key
+ * @return index of the slot of the key, NOT_FOUND if not in the map
+ */
+size_t find_slot (const hashmap *hash_map, const_keyT key, uint64_t hash)
+{
+  unsigned char fragment = (unsigned char) (hash & CONTROL_HASH_MASK);
+  size_t group = first_group (hash_map->capacity, hash);
+  for (size_t step = 1; step <= hash_map->capacity / GROUP_WIDTH; ++step)
+    {
+      const unsigned char *control = hash_map->control + group;
+      for (unsigned int mask = match_byte (control, fragment); mask != 0;
+           mask &= mask - 1)
+        {
+          size_t ind = group + __builtin_ctz (mask);
+          if (hash_map->key_cmp (slot_at (hash_map, ind), key) == 1)
+            {
+              return ind;
+            }
+        }
+      if (match_byte (control, CONTROL_EMPTY) != 0)
+        {
+          return NOT_FOUND;
+        }
+      group = next_group (hash_map->capacity, group, step);
+    }
+  return NOT_FOUND;
+}
+
+/**
+ * Finds the first empty or deleted slot in the groups the hash probes.
+ * @param hash_map the hash table
+ * @param hash the mixed hash of a key
+ * @return index of the slot
+ */
+size_t find_free_slot (const hashmap *hash_map, uint64_t hash)
+{
+  size_t group = first_group (hash_map->capacity, hash);
+  unsigned int mask = match_free (hash_map->control + group);
+  for (size_t step = 1; mask == 0; ++step)
+    {
+      group = next_group (hash_map->capacity, group, step);
+      mask = match_free (hash_map->control + group);
+    }
+  return group + __builtin_ctz (mask);
+}
+
+/**
+ * Moves the keys and values to new slots, dropping the deleted ones.
+ * Nothing is copied but the bytes of the slots themselves.
+ * @param hash_map the hash table
+ * @param capacity the new number of slots, a power of 2 bigger than size
+ * @return 1 if successful else 0, leaving the map as it was
+ */
+int resize_slots (hashmap *hash_map, size_t capacity)
+{
+  unsigned char *control = NULL;
+  unsigned char *slots = NULL;
+  if (alloc_slots (capacity, hash_map->slot_size, &control, &slots) == 0)
+    {
+      return 0;
+    }
+  hashmap old = *hash_map;
+  hash_map->control = control;
+  hash_map->slots = slots;
+  hash_map->capacity = capacity;
+  hash_map->deleted = 0;
+  for (size_t ind = 0; ind < old.capacity; ++ind)
+    {
+      if ((old.control[ind] & ~CONTROL_HASH_MASK) == 0)
+        {
+          uint64_t hash = mix_hash (hash_map, slot_at (&old, ind));
+          size_t free_ind = find_free_slot (hash_map, hash);
+          control[free_ind] = old.control[ind];
+          memcpy (slot_at (hash_map, free_ind), slot_at (&old, ind),
+                  hash_map->slot_size);
+        }
+    }
+  free (old.control);
+  free (old.slots);
+  return 1;
+}
+
+/**
+ * Allocates dynamically new hash map element with the inline backend, for
+ * keys and values of fixed sizes that can be copied byte by byte.
+ * @param func a function which "hashes" keys.
+ * @param key_cmp a function which compares keys.
+ * @param key_size, value_size sizes of the keys and values, in bytes.
+ * @return pointer to dynamically allocated hashmap.
+ * @if_fail return NULL.
+ */
+hashmap *hashmap_alloc_inline (hash_func func, pair_key_cmp key_cmp,
+                               size_t key_size, size_t value_size)
+{
+  if (func == NULL || key_cmp == NULL || key_size == 0)
+    {
+      return NULL;
+    }
+  hashmap *map = malloc (sizeof (hashmap));
+  if (map == NULL)
+    {
+      return NULL;
+    }
+  map->buckets = NULL;
+  map->size = 0;
+  map->capacity = HASH_MAP_INITIAL_CAP;
+  map->hash_func = func;
+  map->deleted = 0;
+  map->key_size = key_size;
+  map->value_size = value_size;
+  map->slot_size = align_up (key_size) + align_up (value_size);
+  map->key_cmp = key_cmp;
+  slab_pool_init (&map->pairs, sizeof (pair));
+  slab_pool_init (&map->vectors, sizeof (vector));
+  map->incremental = 0;
+  map->old_buckets = NULL;
+  map->old_capacity = 0;
+  map->migrated = 0;
+  if (alloc_slots (map->capacity, map->slot_size, &map->control,
+                   &map->slots) == 0)
+    {
+      free (map);
+      return NULL;
+    }
+  return map;
+}
+
+/**
+ * Inserts a copy of the pair's key and value to an inline hash map. Deleted
+ * slots count towards the load, so when they fill the map it is rehashed in
+ * place rather than grown.
+ * @param hash_map a hash map with the inline backend.
+ * @param in_pair the pair to be copied.
+ * @return returns 1 for successful insertion, 0 otherwise.
+ */
+int inline_insert (hashmap *hash_map, const pair *in_pair)
+{
+  uint64_t hash = mix_hash (hash_map, in_pair->key);
+  if (find_slot (hash_map, in_pair->key, hash) != NOT_FOUND)
+    {
+      return 0;
+    }
+  double max_used = HASH_MAP_MAX_LOAD_FACTOR * (double) hash_map->capacity;
+  if ((double) (hash_map->size + hash_map->deleted + 1) > max_used)
+    {
+      size_t capacity = hash_map->capacity;
+      if ((double) (hash_map->size + 1) > max_used / 2)
+        {
+          capacity *= HASH_MAP_GROWTH_FACTOR;
+        }
+      if (resize_slots (hash_map, capacity) == 0)
+        {
+          return 0;
+        }
+    }
+  size_t ind = find_free_slot (hash_map, hash);
+  if (hash_map->control[ind] == CONTROL_DELETED)
+    {
+      hash_map->deleted--;
+    }
+  hash_map->control[ind] = (unsigned char) (hash & CONTROL_HASH_MASK);
+  memcpy (slot_at (hash_map, ind), in_pair->key, hash_map->key_size);
+  memcpy (value_at (hash_map, ind), in_pair->value, hash_map->value_size);
+  hash_map->size++;
+  return 1;
+}
+
+/**
+ * @param hash_map a hash map with the inline backend.
+ * @param key the key to be checked.
+ * @return pointer to the value associated with key inside the map if exists,
+ * NULL otherwise.
+ */
+valueT inline_at (const hashmap *hash_map, const_keyT key)
+{
+  size_t ind = find_slot (hash_map, key, mix_hash (hash_map, key));
+  if (ind == NOT_FOUND)
+    {
+      return NULL;
+    }
+  return value_at (hash_map, ind);
+}
+
+/**
+ * Erases the key and its value from an inline hash map. The slot becomes
+ * empty if its group has an empty slot, since then no probing passes
+ * through the group, and deleted otherwise. The map shrinks below
+ * HASH_MAP_MIN_LOAD_FACTOR, but not below HASH_MAP_INITIAL_CAP.
+ * @param hash_map a hash map with the inline backend.
+ * @param key the key to be erased.
+ * @return 1 if the erasing was done successfully, 0 otherwise.
+ */
+int inline_erase (hashmap *hash_map, const_keyT key)
+{
+  size_t ind = find_slot (hash_map, key, mix_hash (hash_map, key));
+  if (ind == NOT_FOUND)
+    {
+      return 0;
+    }
+  size_t group = ind & ~(size_t) (GROUP_WIDTH - 1);
+  if (match_byte (hash_map->control + group, CONTROL_EMPTY) != 0)
+    {
+      hash_map->control[ind] = CONTROL_EMPTY;
+    }
+  else
+    {
+      hash_map->control[ind] = CONTROL_DELETED;
+      hash_map->deleted++;
+    }
+  hash_map->size--;
+  if (hash_map->capacity > HASH_MAP_INITIAL_CAP
+      && hashmap_get_load_factor (hash_map) < HASH_MAP_MIN_LOAD_FACTOR)
+    {
+      resize_slots (hash_map, hash_map->capacity / HASH_MAP_GROWTH_FACTOR);
+    }
+  return 1;
+}
+
+/**
+ * Applies valT_func to the values of the keys keyT_func accepts.
+ * @param hash_map a hash map with the inline backend.
+ * @param keyT_func a function that checks a condition on keyT.
+ * @param valT_func a function that modifies valueT, in-place.
+ * @return number of changed values.
+ */
+int inline_apply_if (const hashmap *hash_map, keyT_func keyT_func,
+                     valueT_func valT_func)
+{
+  int operated_on = 0;
+  for (size_t ind = 0; ind < hash_map->capacity; ind++)
+    {
+      if ((hash_map->control[ind] & ~CONTROL_HASH_MASK) == 0
+          && keyT_func (slot_at (hash_map, ind)) == 1)
+        {
+          valT_func (value_at (hash_map, ind));
+          operated_on++;
+        }
+    }
+  return operated_on;
+}
+
+/**
+ * Frees the slots and control bytes of an inline hash map.
+ * @param hash_map a hash map with the inline backend.
+ */
+void inline_free (hashmap *hash_map)
+{
+  free (hash_map->control);
+  hash_map->control = NULL;
+  free (hash_map->slots);
+  hash_map->slots = NULL;
+}
@@ -0,0 +1,186 @@
+#ifndef HASHMAP_INLINE_H_
+#define HASHMAP_INLINE_H_
+
+#include <stdint.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "hashmap.h"
+
+/**
+ * @def CONTROL_EMPTY
+ * The control byte of a slot that was never used since the last rehash.
+ * Lookups stop at it.
+ */
+#define CONTROL_EMPTY 0x80
+
+/**
+ * @def CONTROL_DELETED
+ * The control byte of a slot whose pair was erased. Lookups probe past it,
+ * insertions reuse it.
+ */
+#define CONTROL_DELETED 0xFE
+
+/**
+ * @def CONTROL_HASH_MASK
+ * The bits of the hash kept in the control byte of a full slot. Full slots
+ * have the top bit clear, which tells them from empty and deleted ones.
+ */
+#define CONTROL_HASH_MASK 0x7FULL
+
+/**
+ * @def CONTROL_HASH_BITS
+ * Number of bits of CONTROL_HASH_MASK. The rest of the hash picks the slot
+ * the probing starts from.
+ */
+#define CONTROL_HASH_BITS 7
+
+/**
+ * @def GROUP_WIDTH
+ * Number of slots whose control bytes are matched at once, the width of an
+ * SSE2 register. The slots are probed a group at a time, so the capacity
+ * must be a multiple of it: HASH_MAP_INITIAL_CAP is the smallest capacity.
+ */
+#define GROUP_WIDTH 16
+
+/**
+ * @def SLOT_ALIGNMENT
+ * The alignment of the keys and values inside the slots.
+ */
+#define SLOT_ALIGNMENT 8UL
+
+/**
+ * @def MIX_MULTIPLIER_1, MIX_MULTIPLIER_2
+ * The multipliers of mix_bits.
+ */
+#define MIX_MULTIPLIER_1 0xff51afd7ed558ccdULL
+#define MIX_MULTIPLIER_2 0xc4ceb9fe1a85ec53ULL
+
+/*
+ * The probing below is shared by the inline backend and the maps of
+ * hashmap_template.h, so it is defined here, inline.
+ */
+
+/**
+ * Mixes the bits of a hash, since the hash functions of the keys may leave
+ * the high ones all 0 and the control bytes and the starting slots need
+ * bits of their own.
+ * @param hash the hash
+ * @return the mixed hash
+ */
+static inline uint64_t mix_bits (uint64_t hash)
+{
+  hash ^= hash >> 33;
+  hash *= MIX_MULTIPLIER_1;
+  hash ^= hash >> 33;
+  hash *= MIX_MULTIPLIER_2;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+/**
+ * @param group the GROUP_WIDTH control bytes of a group
+ * @param byte a control byte
+ * @return a mask with bit i set if control byte i of the group is byte
+ */
+static inline unsigned int match_byte (const unsigned char *group,
+                                       unsigned char byte)
+{
+#ifdef __SSE2__
+  __m128i bytes = _mm_loadu_si128 ((const __m128i *) group);
+  return (unsigned int) _mm_movemask_epi8
+      (_mm_cmpeq_epi8 (bytes, _mm_set1_epi8 ((char) byte)));
+#else
+  unsigned int mask = 0;
+  for (int ind = 0; ind < GROUP_WIDTH; ++ind)
+    {
+      mask |= (unsigned int) (group[ind] == byte) << ind;
+    }
+  return mask;
+#endif
+}
+
+/**
+ * @param group the GROUP_WIDTH control bytes of a group
+ * @return a mask with bit i set if slot i of the group is empty or deleted,
+ * which are the control bytes with the top bit set
+ */
+static inline unsigned int match_free (const unsigned char *group)
+{
+#ifdef __SSE2__
+  return (unsigned int) _mm_movemask_epi8
+      (_mm_loadu_si128 ((const __m128i *) group));
+#else
+  unsigned int mask = 0;
+  for (int ind = 0; ind < GROUP_WIDTH; ++ind)
+    {
+      mask |= (unsigned int) (group[ind] >> 7) << ind;
+    }
+  return mask;
+#endif
+}
+
+/**
+ * @param capacity the number of slots
+ * @param hash the mixed hash of a key
+ * @return index of the first slot of the group the probing starts from
+ */
+static inline size_t first_group (size_t capacity, uint64_t hash)
+{
+  size_t mask = capacity / GROUP_WIDTH - 1;
+  return ((size_t) (hash >> CONTROL_HASH_BITS) & mask) * GROUP_WIDTH;
+}
+
+/**
+ * @param capacity the number of slots
+ * @param group index of the first slot of a group
+ * @param step number of groups probed so far
+ * @return index of the first slot of the next group to probe. Jumping 1, 2,
+ * 3... groups visits every group, as their number is a power of 2.
+ */
+static inline size_t next_group (size_t capacity, size_t group, size_t step)
+{
+  return (group + step * GROUP_WIDTH) & (capacity - 1);
+}
+
+/**
+ * Inserts a copy of the pair's key and value to an inline hash map.
+ * @param hash_map a hash map with the inline backend.
+ * @param in_pair the pair to be copied.
+ * @return returns 1 for successful insertion, 0 otherwise.
+ */
+int inline_insert (hashmap *hash_map, const pair *in_pair);
+
+/**
+ * @param hash_map a hash map with the inline backend.
+ * @param key the key to be checked.
+ * @return pointer to the value associated with key inside the map if exists,
+ * NULL otherwise.
+ */
+valueT inline_at (const hashmap *hash_map, const_keyT key);
+
+/**
+ * Erases the key and its value from an inline hash map.
+ * @param hash_map a hash map with the inline backend.
+ * @param key the key to be erased.
+ * @return 1 if the erasing was done successfully, 0 otherwise.
+ */
+int inline_erase (hashmap *hash_map, const_keyT key);
+
+/**
+ * Applies valT_func to the values of the keys keyT_func accepts.
+ * @param hash_map a hash map with the inline backend.
+ * @param keyT_func a function that checks a condition on keyT.
+ * @param valT_func a function that modifies valueT, in-place.
+ * @return number of changed values.
+ */
+int inline_apply_if (const hashmap *hash_map, keyT_func keyT_func,
+                     valueT_func valT_func);
+
+/**
+ * Frees the slots and control bytes of an inline hash map.
+ * @param hash_map a hash map with the inline backend.
+ */
+void inline_free (hashmap *hash_map);
+
+#endif //HASHMAP_INLINE_H_
@@ -0,0 +1,237 @@
+#ifndef HASHMAP_TEMPLATE_H_
+#define HASHMAP_TEMPLATE_H_
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "hashmap_inline.h"
+
+/**
+ * @def DEFINE_HASHMAP
+ * Defines a hash map specialized to one type of keys and one of values,
+ * which stores both by value in its slots, like the inline backend does
+ * (see hashmap_alloc_inline), with the same probing and load factors. The
+ * hash and the comparison are called directly, so the compiler can inline
+ * them, and the keys and values are copied by assignment: they must be
+ * plain data. A key that points to data, like a string, is stored as the
+ * pointer, and the data must outlive the map.
+ * The generic hashmap stays for the keys and values that need copying or
+ * freeing functions.
+ *
+ * Defines the types name and name_slot, and the functions:
+ *   name *name_alloc (void);
+ *   void name_free (name **p_map);
+ *   int name_insert (name *map, KeyT key, ValT value);
+ *   ValT *name_at (const name *map, KeyT key);
+ *   int name_erase (name *map, KeyT key);
+ *   double name_get_load_factor (const name *map);
+ * which behave like the functions of hashmap.h of the same names.
+ *
+ * Example: DEFINE_HASHMAP (int_map, int, int, hash_int_key, int_eq)
+ * @param name the name of the map type, and the prefix of its functions.
+ * @param KeyT, ValT the types of the keys and values.
+ * @param hash a function or macro which receives a KeyT and returns a
+ * size_t "hash" of it.
+ * @param eq a function or macro which receives two KeyT and returns non 0
+ * if they are equal, 0 otherwise.
+ */
+#define DEFINE_HASHMAP(name, KeyT, ValT, hash, eq)                            \
+                                                                              \
+typedef struct name##_slot {                                                  \
+    KeyT key;                                                                 \
+    ValT value;                                                               \
+} name##_slot;                                                                \
+                                                                              \
+typedef struct name {                                                         \
+    unsigned char *control;                                                   \
+    name##_slot *slots;                                                       \
+    size_t size;                                                              \
+    size_t capacity;                                                          \
+    size_t deleted;                                                           \
+} name;                                                                       \
+                                                                              \
+static inline int name##_alloc_slots (size_t capacity,                        \
+                                      unsigned char **control,                \
+                                      name##_slot **slots)                    \
+{                                                                             \
+  *control = malloc (capacity);                                               \
+  *slots = malloc (capacity * sizeof (name##_slot));                          \
+  if (*control == NULL || *slots == NULL)                                     \
+    {                                                                         \
+      free (*control);                                                        \
+      free (*slots);                                                          \
+      return 0;                                                               \
+    }                                                                         \
+  memset (*control, CONTROL_EMPTY, capacity);                                 \
+  return 1;                                                                   \
+}                                                                             \
+                                                                              \
+static inline name *name##_alloc (void)                                       \
+{                                                                             \
+  name *map = malloc (sizeof (name));                                         \
+  if (map == NULL)                                                            \
+    {                                                                         \
+      return NULL;                                                            \
+    }                                                                         \
+  map->size = 0;                                                              \
+  map->capacity = HASH_MAP_INITIAL_CAP;                                       \
+  map->deleted = 0;                                                           \
+  if (name##_alloc_slots (map->capacity, &map->control, &map->slots) == 0)    \
+    {                                                                         \
+      free (map);                                                             \
+      return NULL;                                                            \
+    }                                                                         \
+  return map;                                                                 \
+}                                                                             \
+                                                                              \
+static inline void name##_free (name **p_map)                                 \
+{                                                                             \
+  if (p_map == NULL || *p_map == NULL)                                        \
+    {                                                                         \
+      return;                                                                 \
+    }                                                                         \
+  free ((*p_map)->control);                                                   \
+  free ((*p_map)->slots);                                                     \
+  free (*p_map);                                                              \
+  *p_map = NULL;                                                              \
+}                                                                             \
+                                                                              \
+static inline size_t name##_find (const name *map, KeyT key, uint64_t mixed)  \
+{                                                                             \
+  unsigned char fragment = (unsigned char) (mixed & CONTROL_HASH_MASK);       \
+  size_t group = first_group (map->capacity, mixed);                          \
+  for (size_t step = 1; step <= map->capacity / GROUP_WIDTH; ++step)          \
+    {                                                                         \
+      const unsigned char *control = map->control + group;                    \
+      for (unsigned int mask = match_byte (control, fragment); mask != 0;     \
+           mask &= mask - 1)                                                  \
+        {                                                                     \
+          size_t ind = group + __builtin_ctz (mask);                          \
+          if (eq (map->slots[ind].key, key))                                  \
+            {                                                                 \
+              return ind;                                                     \
+            }                                                                 \
+        }                                                                     \
+      if (match_byte (control, CONTROL_EMPTY) != 0)                           \
+        {                                                                     \
+          return SIZE_MAX;                                                    \
+        }                                                                     \
+      group = next_group (map->capacity, group, step);                        \
+    }                                                                         \
+  return SIZE_MAX;                                                            \
+}                                                                             \
+                                                                              \
+static inline size_t name##_find_free (const name *map, uint64_t mixed)       \
+{                                                                             \
+  size_t group = first_group (map->capacity, mixed);                          \
+  unsigned int mask = match_free (map->control + group);                      \
+  for (size_t step = 1; mask == 0; ++step)                                    \
+    {                                                                         \
+      group = next_group (map->capacity, group, step);                        \
+      mask = match_free (map->control + group);                               \
+    }                                                                         \
+  return group + __builtin_ctz (mask);                                        \
+}                                                                             \
+                                                                              \
+static inline int name##_resize (name *map, size_t capacity)                  \
+{                                                                             \
+  unsigned char *control = NULL;                                              \
+  name##_slot *slots = NULL;                                                  \
+  if (name##_alloc_slots (capacity, &control, &slots) == 0)                   \
+    {                                                                         \
+      return 0;                                                               \
+    }                                                                         \
+  name old = *map;                                                            \
+  map->control = control;                                                     \
+  map->slots = slots;                                                         \
+  map->capacity = capacity;                                                   \
+  map->deleted = 0;                                                           \
+  for (size_t ind = 0; ind < old.capacity; ++ind)                             \
+    {                                                                         \
+      if ((old.control[ind] & ~CONTROL_HASH_MASK) == 0)                       \
+        {                                                                     \
+          uint64_t mixed = mix_bits ((uint64_t) hash (old.slots[ind].key));   \
+          size_t free_ind = name##_find_free (map, mixed);                    \
+          control[free_ind] = old.control[ind];                               \
+          slots[free_ind] = old.slots[ind];                                   \
+        }                                                                     \
+    }                                                                         \
+  free (old.control);                                                         \
+  free (old.slots);                                                           \
+  return 1;                                                                   \
+}                                                                             \
+                                                                              \
+static inline int name##_insert (name *map, KeyT key, ValT value)             \
+{                                                                             \
+  uint64_t mixed = mix_bits ((uint64_t) hash (key));                          \
+  if (name##_find (map, key, mixed) != SIZE_MAX)                              \
+    {                                                                         \
+      return 0;                                                               \
+    }                                                                         \
+  double max_used = HASH_MAP_MAX_LOAD_FACTOR * (double) map->capacity;        \
+  if ((double) (map->size + map->deleted + 1) > max_used)                     \
+    {                                                                         \
+      size_t capacity = map->capacity;                                        \
+      if ((double) (map->size + 1) > max_used / 2)                            \
+        {                                                                     \
+          capacity *= HASH_MAP_GROWTH_FACTOR;                                 \
+        }                                                                     \
+      if (name##_resize (map, capacity) == 0)                                 \
+        {                                                                     \
+          return 0;                                                           \
+        }                                                                     \
+    }                                                                         \
+  size_t ind = name##_find_free (map, mixed);                                 \
+  if (map->control[ind] == CONTROL_DELETED)                                   \
+    {                                                                         \
+      map->deleted--;                                                         \
+    }                                                                         \
+  map->control[ind] = (unsigned char) (mixed & CONTROL_HASH_MASK);            \
+  map->slots[ind].key = key;                                                  \
+  map->slots[ind].value = value;                                              \
+  map->size++;                                                                \
+  return 1;                                                                   \
+}                                                                             \
+                                                                              \
+static inline ValT *name##_at (const name *map, KeyT key)                     \
+{                                                                             \
+  size_t ind = name##_find (map, key, mix_bits ((uint64_t) hash (key)));      \
+  if (ind == SIZE_MAX)                                                        \
+    {                                                                         \
+      return NULL;                                                            \
+    }                                                                         \
+  return &map->slots[ind].value;                                              \
+}                                                                             \
+                                                                              \
+static inline double name##_get_load_factor (const name *map)                 \
+{                                                                             \
+  return (double) map->size / (double) map->capacity;                         \
+}                                                                             \
+                                                                              \
+static inline int name##_erase (name *map, KeyT key)                          \
+{                                                                             \
+  size_t ind = name##_find (map, key, mix_bits ((uint64_t) hash (key)));      \
+  if (ind == SIZE_MAX)                                                        \
+    {                                                                         \
+      return 0;                                                               \
+    }                                                                         \
+  size_t group = ind & ~(size_t) (GROUP_WIDTH - 1);                           \
+  if (match_byte (map->control + group, CONTROL_EMPTY) != 0)                  \
+    {                                                                         \
+      map->control[ind] = CONTROL_EMPTY;                                      \
+    }                                                                         \
+  else                                                                        \
+    {                                                                         \
+      map->control[ind] = CONTROL_DELETED;                                    \
+      map->deleted++;                                                         \
+    }                                                                         \
+  map->size--;                                                                \
+  if (map->capacity > HASH_MAP_INITIAL_CAP                                    \
+      && name##_get_load_factor (map) < HASH_MAP_MIN_LOAD_FACTOR)             \
+    {                                                                         \
+      name##_resize (map, map->capacity / HASH_MAP_GROWTH_FACTOR);            \
+    }                                                                         \
+  return 1;                                                                   \
+}
+
+#endif //HASHMAP_TEMPLATE_H_
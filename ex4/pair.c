@@ -14,7 +14,30 @@ pair *pair_alloc (
     const pair_key_cmp key_cmp, const pair_value_cmp value_cmp,
     const pair_key_free key_free, const pair_value_free value_free)
 {
-  pair *p = malloc (sizeof (pair));
+  return pair_alloc_from (NULL, key, value, key_cpy, value_cpy, key_cmp,
+                          value_cmp, key_free, value_free);
+}
+
+/**
+ * Allocates a new pair from a pool of blocks of sizeof (pair) bytes.
+ * @param pool - the pool, NULL to allocate by malloc.
+ * @param key, value - the key and value.
+ * @param key_cpy, value_cpy - copy functions for key and value.
+ * @param key_cmp, value_cmp - compare functions for key and value.
+ * @param key_free, value_free - free functions for key and value.
+ * @return the allocated pair, NULL if failed.
+ */
+pair *pair_alloc_from (
+    slab_pool *pool, const_keyT key, const_valueT value,
+    const pair_key_cpy key_cpy, const pair_value_cpy value_cpy,
+    const pair_key_cmp key_cmp, const pair_value_cmp value_cmp,
+    const pair_key_free key_free, const pair_value_free value_free)
+{
+  pair *p = pool != NULL ? slab_pool_alloc (pool) : malloc (sizeof (pair));
+  if (p == NULL)
+    {
+      return NULL;
+    }
   p->key = key_cpy (key);
   p->value = value_cpy (value);
   p->key_cpy = key_cpy;
@@ -23,11 +46,14 @@ pair *pair_alloc (
   p->value_cmp = value_cmp;
   p->key_free = key_free;
   p->value_free = value_free;
+  p->pool = pool;
   return p;
 }
 
 /**
- * Creates a new (dynamically allocated) copy of the given old_pair.
+ * Creates a new (dynamically allocated) copy of the given old_pair. The
+ * copy is allocated by malloc even if old_pair came from a pool, so it does
+ * not depend on the pool, or the hash map owning it, staying alive.
  * @param old_pair old_pair to be copied.
  * @return new dynamically allocated old_pair if succeeded, NULL otherwise.
  */
@@ -38,10 +64,11 @@ void *pair_copy (const void *p)
       return NULL;
     }
   const pair *old_pair = (const pair *) p;
-  pair *new_pair = pair_alloc (old_pair->key, old_pair->value,
-                               old_pair->key_cpy, old_pair->value_cpy,
-                               old_pair->key_cmp, old_pair->value_cmp,
-                               old_pair->key_free, old_pair->value_free);
+  pair *new_pair = pair_alloc_from (NULL, old_pair->key,
+                                    old_pair->value, old_pair->key_cpy,
+                                    old_pair->value_cpy, old_pair->key_cmp,
+                                    old_pair->value_cmp, old_pair->key_free,
+                                    old_pair->value_free);
   return new_pair;
 }
 
@@ -74,6 +101,13 @@ void pair_free (void ** p)
   pair **p_pair = (pair **) p;
   (*p_pair)->key_free (&(*p_pair)->key);
   (*p_pair)->value_free (&(*p_pair)->value);
-  free (*p_pair);
+  if ((*p_pair)->pool != NULL)
+    {
+      slab_pool_release ((*p_pair)->pool, *p_pair);
+    }
+  else
+    {
+      free (*p_pair);
+    }
   *p_pair = NULL;
 }
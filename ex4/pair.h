@@ -2,6 +2,7 @@
 #define PAIR_H_
 
 #include <stdlib.h>
+#include "slab.h"
 
 /**
  * @typedef keyT, valueT, const_keyT, const_valueT
@@ -39,6 +40,7 @@ typedef void (*pair_value_free) (valueT *);
  * @param key_cpy, value_cpy - copy functions for key and value.
  * @param key_cmp, value_cmp - compare functions for key and value.
  * @param key_free, value_free - free functions for key and value.
+ * @param pool - the pool the pair was allocated from, NULL if by malloc.
  */
 typedef struct pair {
     keyT key;
@@ -49,6 +51,7 @@ typedef struct pair {
     pair_value_cmp value_cmp;
     pair_key_free key_free;
     pair_value_free value_free;
+    slab_pool *pool;
 } pair;
 
 /**
@@ -66,7 +69,23 @@ pair *pair_alloc (
     pair_key_free key_free, pair_value_free value_free);
 
 /**
- * Creates a new (dynamically allocated) copy of the given old_pair.
+ * Allocates a new pair from a pool of blocks of sizeof (pair) bytes.
+ * @param pool - the pool, NULL to allocate by malloc.
+ * @param key, value - the key and value.
+ * @param key_cpy, value_cpy - copy functions for key and value.
+ * @param key_cmp, value_cmp - compare functions for key and value.
+ * @param key_free, value_free - free functions for key and value.
+ * @return the allocated pair, NULL if failed.
+ */
+pair *pair_alloc_from (
+    slab_pool *pool, const_keyT key, const_valueT value,
+    pair_key_cpy key_cpy, pair_value_cpy value_cpy,
+    pair_key_cmp key_cmp, pair_value_cmp value_cmp,
+    pair_key_free key_free, pair_value_free value_free);
+
+/**
+ * Creates a new (dynamically allocated) copy of the given old_pair, by
+ * malloc even if old_pair came from a pool.
  * @param old_pair old_pair to be copied.
  * @return new dynamically allocated old_pair if succeeded, NULL otherwise.
  */
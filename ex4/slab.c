@@ -0,0 +1,110 @@
+#include "slab.h"
+
+/**
+ * @return the size of a slab header, rounded up to SLAB_ALIGNMENT so the
+ * blocks after it are aligned
+ */
+size_t slab_header_size (void)
+{
+  return (sizeof (slab) + SLAB_ALIGNMENT - 1) & ~(SLAB_ALIGNMENT - 1);
+}
+
+/**
+ * Initializes an empty pool, which allocates nothing until the first block
+ * is asked for.
+ * @param pool the pool.
+ * @param block_size the size of the blocks.
+ */
+void slab_pool_init (slab_pool *pool, size_t block_size)
+{
+  if (block_size < sizeof (void *))
+    {
+      block_size = sizeof (void *);
+    }
+  pool->block_size = (block_size + SLAB_ALIGNMENT - 1)
+                     & ~(SLAB_ALIGNMENT - 1);
+  pool->slabs = NULL;
+  pool->free_list = NULL;
+  pool->unused = 0;
+  pool->slab_blocks = 0;
+  pool->slab_count = 0;
+}
+
+/**
+ * Allocates a new slab, twice the size of the newest one.
+ * @param pool the pool.
+ * @return 1 if successful else 0
+ */
+int add_slab (slab_pool *pool)
+{
+  size_t blocks = SLAB_INITIAL_BLOCKS;
+  if (pool->slab_blocks != 0)
+    {
+      blocks = pool->slab_blocks * 2;
+      if (blocks > SLAB_MAX_BLOCKS)
+        {
+          blocks = SLAB_MAX_BLOCKS;
+        }
+    }
+  slab *new_slab = malloc (slab_header_size () + blocks * pool->block_size);
+  if (new_slab == NULL)
+    {
+      return 0;
+    }
+  new_slab->next = pool->slabs;
+  pool->slabs = new_slab;
+  pool->unused = blocks;
+  pool->slab_blocks = blocks;
+  pool->slab_count++;
+  return 1;
+}
+
+/**
+ * Hands out a block: a released one if there is any, else the next unused
+ * one of the newest slab, allocating a new slab when it has none left.
+ * @param pool the pool.
+ * @return the block, NULL if a new slab could not be allocated.
+ */
+void *slab_pool_alloc (slab_pool *pool)
+{
+  if (pool->free_list != NULL)
+    {
+      void *block = pool->free_list;
+      pool->free_list = *(void **) block;
+      return block;
+    }
+  if (pool->unused == 0 && add_slab (pool) == 0)
+    {
+      return NULL;
+    }
+  char *blocks = (char *) pool->slabs + slab_header_size ();
+  pool->unused--;
+  return blocks + (pool->slab_blocks - pool->unused - 1) * pool->block_size;
+}
+
+/**
+ * Takes a block back to the free list of its pool.
+ * @param pool the pool the block came from.
+ * @param block the block.
+ */
+void slab_pool_release (slab_pool *pool, void *block)
+{
+  *(void **) block = pool->free_list;
+  pool->free_list = block;
+}
+
+/**
+ * Frees all the slabs of a pool at once, with all the blocks in them,
+ * whether released or not, and leaves the pool empty.
+ * @param pool the pool.
+ */
+void slab_pool_clear (slab_pool *pool)
+{
+  while (pool->slabs != NULL)
+    {
+      slab *next = pool->slabs->next;
+      free (pool->slabs);
+      pool->slabs = next;
+    }
+  slab_pool_init (pool, pool->block_size);
+}
@@ -0,0 +1,83 @@
+#ifndef SLAB_H_
+#define SLAB_H_
+
+#include <stdlib.h>
+
+/**
+ * @def SLAB_ALIGNMENT
+ * The alignment of the blocks a slab pool hands out.
+ */
+#define SLAB_ALIGNMENT 16UL
+
+/**
+ * @def SLAB_INITIAL_BLOCKS
+ * The number of blocks in the first slab of a pool. Every slab after it
+ * has twice the blocks of the one before, up to SLAB_MAX_BLOCKS.
+ */
+#define SLAB_INITIAL_BLOCKS 16UL
+
+/**
+ * @def SLAB_MAX_BLOCKS
+ * The maximal number of blocks in a slab.
+ */
+#define SLAB_MAX_BLOCKS 4096UL
+
+/**
+ * @struct slab - the header of a slab, its blocks follow it.
+ * @param next the slab allocated before it.
+ */
+typedef struct slab {
+    struct slab *next;
+} slab;
+
+/**
+ * @struct slab_pool - hands out blocks of one size, carved from large
+ * slabs, and takes released ones back to a free list to hand out again.
+ * @param block_size the size of a block, rounded up to SLAB_ALIGNMENT.
+ * @param slabs the newest slab, which links to the older ones.
+ * @param free_list the released blocks, each holding a pointer to the next.
+ * @param unused number of blocks at the end of the newest slab which were
+ * never handed out.
+ * @param slab_blocks number of blocks in the newest slab.
+ * @param slab_count number of slabs.
+ */
+typedef struct slab_pool {
+    size_t block_size;
+    slab *slabs;
+    void *free_list;
+    size_t unused;
+    size_t slab_blocks;
+    size_t slab_count;
+} slab_pool;
+
+/**
+ * Initializes an empty pool, which allocates nothing until the first block
+ * is asked for.
+ * @param pool the pool.
+ * @param block_size the size of the blocks.
+ */
+void slab_pool_init (slab_pool *pool, size_t block_size);
+
+/**
+ * Hands out a block: a released one if there is any, else the next unused
+ * one of the newest slab, allocating a new slab when it has none left.
+ * @param pool the pool.
+ * @return the block, NULL if a new slab could not be allocated.
+ */
+void *slab_pool_alloc (slab_pool *pool);
+
+/**
+ * Takes a block back to the free list of its pool.
+ * @param pool the pool the block came from.
+ * @param block the block.
+ */
+void slab_pool_release (slab_pool *pool, void *block);
+
+/**
+ * Frees all the slabs of a pool at once, with all the blocks in them,
+ * whether released or not, and leaves the pool empty.
+ * @param pool the pool.
+ */
+void slab_pool_clear (slab_pool *pool);
+
+#endif //SLAB_H_
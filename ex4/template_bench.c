@@ -0,0 +1,399 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "hashmap.h"
+#include "hashmap_template.h"
+#include "hash_funcs.h"
+#include "bench_util.h"
+
+#define USAGE_ERROR "Usage: Input should be <number of keys> optional - \
+<seed>\n"
+#define CHECK_ERROR "Error: The %s %s hash map gave a wrong answer!\n"
+#define BENCH_REPORT "%-11s %-8s %d keys: insert %.1f ns, hit %.1f ns, miss \
+%.1f ns, erase %.1f ns\n"
+#define KEY_FORMAT "key%u"
+#define MAX_KEY_LENGTH 16
+#define MIN_ARGS 2
+#define MAX_ARGS 3
+#define BASE 10
+#define DEFAULT_SEED 1
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+/**
+ * @struct Timings - nanoseconds per operation of every phase.
+ */
+typedef struct Timings {
+    double insert;
+    double hit;
+    double miss;
+    double erase;
+} Timings;
+
+/**
+ * @param key an int
+ * @return its hash, the same as hash_int gives
+ */
+static inline size_t int_hash (int key)
+{
+  return (size_t) key;
+}
+
+/**
+ * @return 1 if the ints are equal, 0 otherwise
+ */
+static inline int int_eq (int a, int b)
+{
+  return a == b;
+}
+
+/**
+ * Hashes a string with 64 bit FNV-1a.
+ * @param key the string
+ * @return its hash
+ */
+static inline size_t str_hash (const char *key)
+{
+  uint64_t hash = FNV_OFFSET;
+  for (; *key != '\0'; ++key)
+    {
+      hash = (hash ^ (unsigned char) *key) * FNV_PRIME;
+    }
+  return (size_t) hash;
+}
+
+/**
+ * @return 1 if the strings are equal, 0 otherwise
+ */
+static inline int str_eq (const char *a, const char *b)
+{
+  return strcmp (a, b) == 0;
+}
+
+DEFINE_HASHMAP (int_map, int, int, int_hash, int_eq)
+DEFINE_HASHMAP (str_map, const char *, int, str_hash, str_eq)
+
+/**
+ * Copies a string, for the chained map that owns copies of its keys.
+ */
+void *str_cpy (const void *elem)
+{
+  char *a = alloc_array ((int) strlen (elem) + 1, sizeof (char));
+  strcpy (a, elem);
+  return a;
+}
+
+int str_cmp (const void *elem_1, const void *elem_2)
+{
+  return str_eq (elem_1, elem_2);
+}
+
+size_t hash_str (const void *elem)
+{
+  return str_hash (elem);
+}
+
+/**
+ * Copies a pointer to a string, for the key of a pair of the inline map,
+ * which stores the pointers.
+ */
+void *str_ptr_cpy (const void *elem)
+{
+  const char **a = alloc_array (1, sizeof (const char *));
+  *a = *((const char *const *) elem);
+  return a;
+}
+
+int str_ptr_cmp (const void *elem_1, const void *elem_2)
+{
+  return str_eq (*((const char *const *) elem_1),
+                 *((const char *const *) elem_2));
+}
+
+size_t hash_str_ptr (const void *elem)
+{
+  return str_hash (*((const char *const *) elem));
+}
+
+/**
+ * Writes the keys as strings, MAX_KEY_LENGTH bytes apart in one block.
+ * @param keys the keys
+ * @param count number of keys
+ * @param strings where to store pointers to the strings
+ * @return the block, on the heap
+ */
+char *make_strings (const int *keys, int count, const char **strings)
+{
+  char *chars = alloc_array (count, MAX_KEY_LENGTH);
+  for (int i = 0; i < count; ++i)
+    {
+      strings[i] = chars + (size_t) i * MAX_KEY_LENGTH;
+      snprintf (chars + (size_t) i * MAX_KEY_LENGTH, MAX_KEY_LENGTH,
+                KEY_FORMAT, (unsigned int) keys[i]);
+    }
+  return chars;
+}
+
+/**
+ * Converts the times between the phases of a run to nanoseconds per
+ * operation.
+ * @param times the start and the ends of inserting, hitting, missing and
+ * erasing
+ * @param count number of keys
+ * @param erasing number of keys erased
+ * @return the timings
+ */
+Timings to_timings (const double *times, int count, int erasing)
+{
+  double scale = count > 0 ? 1e9 / count : 0;
+  return (Timings) {(times[1] - times[0]) * scale,
+                    (times[2] - times[1]) * scale,
+                    (times[3] - times[2]) * scale,
+                    erasing > 0 ? (times[4] - times[3]) * 1e9 / erasing : 0};
+}
+
+/**
+ * Inserts the keys to a generic hash map, looks all of them up, looks up as
+ * many keys that are not in it and erases half of the keys, checking every
+ * answer.
+ * @param map an empty hash map
+ * @param pairs the pairs to insert, of the keys
+ * @param keys, missing the keys in the map and keys never inserted, as the
+ * map takes them, key_stride bytes apart
+ * @param key_stride the distance between the keys
+ * @param count number of keys of each
+ * @param timings where to store the nanoseconds per operation
+ * @return 0 if all the answers were right, 1 otherwise
+ */
+int run_generic (hashmap *map, pair *const *pairs, const char *keys,
+                 const char *missing, size_t key_stride, int count,
+                 Timings *timings)
+{
+  if (map == NULL)
+    {
+      printf (ALOCATION_FAILURE);
+      exit (EXIT_FAILURE);
+    }
+  int wrong = 0;
+  int erasing = count / 2;
+  double times[5];
+  times[0] = get_time ();
+  for (int i = 0; i < count; ++i)
+    {
+      wrong |= hashmap_insert (map, pairs[i]) != 1;
+    }
+  times[1] = get_time ();
+  for (int i = 0; i < count; ++i)
+    {
+      const int *value = hashmap_at (map, keys + (size_t) i * key_stride);
+      wrong |= value == NULL || *value != i;
+    }
+  times[2] = get_time ();
+  for (int i = 0; i < count; ++i)
+    {
+      wrong |= hashmap_at (map, missing + (size_t) i * key_stride) != NULL;
+    }
+  times[3] = get_time ();
+  for (int i = 0; i < erasing; ++i)
+    {
+      wrong |= hashmap_erase (map, keys + (size_t) i * key_stride) != 1;
+    }
+  times[4] = get_time ();
+  wrong |= map->size != (size_t) (count - erasing);
+  hashmap_free (&map);
+  *timings = to_timings (times, count, erasing);
+  return wrong;
+}
+
+/**
+ * Runs the workload of run_generic on an int_map.
+ * @param keys, missing the keys in the map and keys never inserted
+ * @param count number of keys of each
+ * @param timings where to store the nanoseconds per operation
+ * @return 0 if all the answers were right, 1 otherwise
+ */
+int run_int_template (const int *keys, const int *missing, int count,
+                      Timings *timings)
+{
+  int_map *map = int_map_alloc ();
+  if (map == NULL)
+    {
+      printf (ALOCATION_FAILURE);
+      exit (EXIT_FAILURE);
+    }
+  int wrong = 0;
+  int erasing = count / 2;
+  double times[5];
+  times[0] = get_time ();
+  for (int i = 0; i < count; ++i)
+    {
+      wrong |= int_map_insert (map, keys[i], i) != 1;
+    }
+  times[1] = get_time ();
+  for (int i = 0; i < count; ++i)
+    {
+      const int *value = int_map_at (map, keys[i]);
+      wrong |= value == NULL || *value != i;
+    }
+  times[2] = get_time ();
+  for (int i = 0; i < count; ++i)
+    {
+      wrong |= int_map_at (map, missing[i]) != NULL;
+    }
+  times[3] = get_time ();
+  for (int i = 0; i < erasing; ++i)
+    {
+      wrong |= int_map_erase (map, keys[i]) != 1;
+    }
+  times[4] = get_time ();
+  wrong |= map->size != (size_t) (count - erasing);
+  int_map_free (&map);
+  *timings = to_timings (times, count, erasing);
+  return wrong;
+}
+
+/**
+ * Runs the workload of run_generic on a str_map.
+ * @param keys, missing the keys in the map and keys never inserted
+ * @param count number of keys of each
+ * @param timings where to store the nanoseconds per operation
+ * @return 0 if all the answers were right, 1 otherwise
+ */
+int run_str_template (const char *const *keys, const char *const *missing,
+                      int count, Timings *timings)
+{
+  str_map *map = str_map_alloc ();
+  if (map == NULL)
+    {
+      printf (ALOCATION_FAILURE);
+      exit (EXIT_FAILURE);
+    }
+  int wrong = 0;
+  int erasing = count / 2;
+  double times[5];
+  times[0] = get_time ();
+  for (int i = 0; i < count; ++i)
+    {
+      wrong |= str_map_insert (map, keys[i], i) != 1;
+    }
+  times[1] = get_time ();
+  for (int i = 0; i < count; ++i)
+    {
+      const int *value = str_map_at (map, keys[i]);
+      wrong |= value == NULL || *value != i;
+    }
+  times[2] = get_time ();
+  for (int i = 0; i < count; ++i)
+    {
+      wrong |= str_map_at (map, missing[i]) != NULL;
+    }
+  times[3] = get_time ();
+  for (int i = 0; i < erasing; ++i)
+    {
+      wrong |= str_map_erase (map, keys[i]) != 1;
+    }
+  times[4] = get_time ();
+  wrong |= map->size != (size_t) (count - erasing);
+  str_map_free (&map);
+  *timings = to_timings (times, count, erasing);
+  return wrong;
+}
+
+/**
+ * Prints the timings of a run, or an error if it gave a wrong answer.
+ * @param name the name of the hash map
+ * @param kind the types of its keys and values
+ * @param count number of keys
+ * @param wrong whether the run gave a wrong answer
+ * @param timings the timings of the run
+ * @return wrong
+ */
+int report (const char *name, const char *kind, int count, int wrong,
+            const Timings *timings)
+{
+  if (wrong)
+    {
+      printf (CHECK_ERROR, name, kind);
+      return 1;
+    }
+  printf (BENCH_REPORT, name, kind, count, timings->insert, timings->hit,
+          timings->miss, timings->erase);
+  return 0;
+}
+
+/**
+ * Measures the generic chained and inline hash maps against the maps
+ * DEFINE_HASHMAP specializes, on the same int to int and string to int
+ * workloads, and prints the nanoseconds per operation of each. The chained
+ * map owns copies of the strings, the inline and specialized maps store
+ * pointers to them.
+ * @param argc
+ * @param argv 1) Number of keys
+ *             2) Optional - Seed, 1 by default
+ */
+int main (int argc, char *argv[])
+{
+  if (argc < MIN_ARGS || argc > MAX_ARGS)
+    {
+      printf (USAGE_ERROR);
+      return EXIT_FAILURE;
+    }
+  char *ptr = NULL;
+  int count = strtol (argv[1], &ptr, BASE);
+  uint32_t seed = argc > MIN_ARGS ? strtoul (argv[2], &ptr, BASE)
+                                  : DEFAULT_SEED;
+  if (count < 0)
+    {
+      printf (USAGE_ERROR);
+      return EXIT_FAILURE;
+    }
+  int *keys = make_keys (0, count, seed);
+  int *missing = make_keys (count, count, seed);
+  const char **strings = alloc_array (count, sizeof (const char *));
+  const char **missing_strings = alloc_array (count, sizeof (const char *));
+  char *chars = make_strings (keys, count, strings);
+  char *missing_chars = make_strings (missing, count, missing_strings);
+  pair **int_pairs = make_pairs (keys, sizeof (int), count, int_cpy,
+                                 int_cmp);
+  pair **str_pairs = make_pairs (chars, MAX_KEY_LENGTH, count, str_cpy,
+                                 str_cmp);
+  pair **str_ptr_pairs = make_pairs (strings, sizeof (const char *), count,
+                                     str_ptr_cpy, str_ptr_cmp);
+
+  int failed = 0;
+  Timings timings;
+  int wrong = run_generic (hashmap_alloc (hash_int), int_pairs,
+                           (const char *) keys, (const char *) missing,
+                           sizeof (int), count, &timings);
+  failed |= report ("chained", "int", count, wrong, &timings);
+  wrong = run_generic (hashmap_alloc_inline (hash_int, int_cmp, sizeof (int),
+                                             sizeof (int)),
+                       int_pairs, (const char *) keys, (const char *) missing,
+                       sizeof (int), count, &timings);
+  failed |= report ("inline", "int", count, wrong, &timings);
+  wrong = run_int_template (keys, missing, count, &timings);
+  failed |= report ("template", "int", count, wrong, &timings);
+  wrong = run_generic (hashmap_alloc (hash_str), str_pairs, chars,
+                       missing_chars, MAX_KEY_LENGTH, count, &timings);
+  failed |= report ("chained", "string", count, wrong, &timings);
+  wrong = run_generic (hashmap_alloc_inline (hash_str_ptr, str_ptr_cmp,
+                                             sizeof (const char *),
+                                             sizeof (int)),
+                       str_ptr_pairs, (const char *) strings,
+                       (const char *) missing_strings, sizeof (const char *),
+                       count, &timings);
+  failed |= report ("inline", "string", count, wrong, &timings);
+  wrong = run_str_template (strings, missing_strings, count, &timings);
+  failed |= report ("template", "string", count, wrong, &timings);
+
+  free_pairs (int_pairs, count);
+  free_pairs (str_pairs, count);
+  free_pairs (str_ptr_pairs, count);
+  free (chars);
+  free (missing_chars);
+  free (strings);
+  free (missing_strings);
+  free (keys);
+  free (missing);
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -54,7 +54,26 @@ int memory_realocation (vector *vector, int flag)
 vector *vector_alloc (vector_elem_cpy elem_copy_func, vector_elem_cmp
                                 elem_cmp_func, vector_elem_free elem_free_func)
 {
-  vector *vec = malloc (sizeof *vec);
+  return vector_alloc_from (NULL, elem_copy_func, elem_cmp_func,
+                            elem_free_func);
+}
+
+/**
+ * Allocates a new vector from a pool of blocks of sizeof (vector) bytes.
+ * Its data is still allocated by malloc, as it changes size.
+ * @param pool the pool, NULL to allocate by malloc.
+ * @param elem_copy_func func which copies the element stored in the vector.
+ * @param elem_cmp_func func which is used to compare elements stored in
+ * the vector.
+ * @param elem_free_func func which frees elements stored in the vector.
+ * @return pointer to the allocated vector.
+ * @if_fail return NULL.
+ */
+vector *vector_alloc_from (slab_pool *pool, vector_elem_cpy elem_copy_func,
+                           vector_elem_cmp elem_cmp_func,
+                           vector_elem_free elem_free_func)
+{
+  vector *vec = pool != NULL ? slab_pool_alloc (pool) : malloc (sizeof *vec);
   if (vec == NULL)
     {
       return NULL;
@@ -66,10 +85,18 @@ vector *vector_alloc (vector_elem_cpy elem_copy_func, vector_elem_cmp
     }
   vec->capacity = VECTOR_INITIAL_CAP;
   vec->size = 0;
+  vec->pool = pool;
   vec->data = malloc (sizeof (*vec->data) * vec->capacity);
   if (vec->data == NULL)
     {
-      free (vec);
+      if (pool != NULL)
+        {
+          slab_pool_release (pool, vec);
+        }
+      else
+        {
+          free (vec);
+        }
       return NULL;
     }
   vec->elem_copy_func = elem_copy_func;
@@ -92,7 +119,14 @@ void vector_free (vector **p_vector)
         }
       free ((*p_vector)->data);
       (*p_vector)->data = NULL;
-      free (*p_vector);
+      if ((*p_vector)->pool != NULL)
+        {
+          slab_pool_release ((*p_vector)->pool, *p_vector);
+        }
+      else
+        {
+          free (*p_vector);
+        }
       *p_vector = NULL;
     }
 }
@@ -159,6 +193,28 @@ int vector_push_back (vector *vector, const void *value)
   return 0;
 }
 
+/**
+ * Adds the value itself, not a copy of it, to the back of the vector, which
+ * takes it over: the vector would free it.
+ * @param vector a pointer to vector.
+ * @param value the value to be added to the vector.
+ * @return 1 if the adding has been done successfully, 0 otherwise.
+ */
+int vector_push_back_move (vector *vector, void *value)
+{
+  if (vector == NULL || value == NULL)
+    {
+      return 0;
+    }
+  vector->size++;
+  if (memory_realocation (vector, INCREASE) == 1)
+    {
+      vector->data[vector->size - 1] = value;
+      return 1;
+    }
+  return 0;
+}
+
 /**
  * This function returns the load factor of the vector.
  * @param vector a vector.
@@ -2,6 +2,7 @@
 #define VECTOR_H_
 
 #include <stdlib.h>
+#include "slab.h"
 
 /**
  * @def VECTOR_INITIAL_CAP
@@ -61,6 +62,7 @@ typedef void (*vector_elem_free)(void **);
  * stored in the vector.
  * @param elem_free_func - a function which frees the elements stored
  * in the vector.
+ * @param pool - the pool the vector was allocated from, NULL if by malloc.
  */
 typedef struct vector {
   size_t capacity;
@@ -69,6 +71,7 @@ typedef struct vector {
   vector_elem_cpy elem_copy_func;
   vector_elem_cmp elem_cmp_func;
   vector_elem_free elem_free_func;
+  slab_pool *pool;
 } vector;
 
 /**
@@ -83,6 +86,20 @@ typedef struct vector {
 vector *vector_alloc(vector_elem_cpy elem_copy_func, vector_elem_cmp elem_cmp_func,
                      vector_elem_free elem_free_func);
 
+/**
+ * Allocates a new vector from a pool of blocks of sizeof (vector) bytes.
+ * Its data is still allocated by malloc, as it changes size.
+ * @param pool the pool, NULL to allocate by malloc.
+ * @param elem_copy_func func which copies the element stored in the vector.
+ * @param elem_cmp_func func which is used to compare elements stored in the vector.
+ * @param elem_free_func func which frees elements stored in the vector.
+ * @return pointer to the allocated vector.
+ * @if_fail return NULL.
+ */
+vector *vector_alloc_from(slab_pool *pool, vector_elem_cpy elem_copy_func,
+                          vector_elem_cmp elem_cmp_func,
+                          vector_elem_free elem_free_func);
+
 /**
  * Frees a vector and the elements the vector itself allocated.
  * @param p_vector pointer to dynamically allocated pointer to vector.
@@ -115,6 +132,15 @@ int vector_find(const vector *vector, const void *value);
  */
 int vector_push_back(vector *vector, const void *value);
 
+/**
+ * Adds the value itself, not a copy of it, to the back of the vector, which
+ * takes it over: the vector would free it.
+ * @param vector a pointer to vector.
+ * @param value the value to be added to the vector.
+ * @return 1 if the adding has been done successfully, 0 otherwise.
+ */
+int vector_push_back_move(vector *vector, void *value);
+
 /**
  * This function returns the load factor of the vector.
  * @param vector a vector.